@@ -0,0 +1,135 @@
+#pragma once
+
+#include <mpi.h>
+#include <algorithm>
+#include <cstring>
+#include <string>
+#include <vector>
+
+// Алгоритмы Allgather: каждый процесс коммуникатора получает блоки count элементов от всех процессов,
+// блок процесса с рангом i помещается в recv_buf начиная с i * count.
+// Данные пересылаются как MPI_BYTE, поэтому T - любой тривиально копируемый тип.
+enum class AllgatherAlgo
+{
+    NATIVE,             // библиотечный MPI_Allgather
+    RING,               // кольцо: p-1 шагов, на каждом шаге один блок соседу
+    RECURSIVE_DOUBLING, // удвоение: log2(p) шагов, объём данных удваивается (только для p = 2^k, иначе Bruck)
+    BRUCK               // Брук: ceil(log2(p)) шагов для любого p, в конце локальный сдвиг блоков
+};
+
+const AllgatherAlgo all_allgather_algos[] = {AllgatherAlgo::NATIVE, AllgatherAlgo::RING,
+                                              AllgatherAlgo::RECURSIVE_DOUBLING, AllgatherAlgo::BRUCK};
+
+inline const char* allgather_name(AllgatherAlgo algo)
+{
+    switch (algo)
+    {
+        case AllgatherAlgo::RING: return "ring";
+        case AllgatherAlgo::RECURSIVE_DOUBLING: return "recursive_doubling";
+        case AllgatherAlgo::BRUCK: return "bruck";
+        default: return "native";
+    }
+}
+
+// разбор имени алгоритма из командной строки; false, если имя неизвестно
+inline bool parse_allgather_algo(const std::string& name, AllgatherAlgo& algo)
+{
+    for (AllgatherAlgo a : all_allgather_algos)
+    {
+        if (name == allgather_name(a))
+        {
+            algo = a;
+            return true;
+        }
+    }
+    return false;
+}
+
+inline void allgather_ring(const char* send_buf, int block, char* recv_buf, MPI_Comm comm, int proc_rank, int proc_num)
+{
+    const int right = (proc_rank + 1) % proc_num;
+    const int left = (proc_rank - 1 + proc_num) % proc_num;
+
+    std::memcpy(recv_buf + static_cast<std::size_t>(proc_rank) * block, send_buf, block);
+    for (int step = 0; step < proc_num - 1; step++)
+    {
+        // отправляется блок, полученный на предыдущем шаге, принимается блок от левого соседа
+        int send_ind = (proc_rank - step + proc_num) % proc_num;
+        int recv_ind = (proc_rank - step - 1 + proc_num) % proc_num;
+        MPI_Sendrecv(recv_buf + static_cast<std::size_t>(send_ind) * block, block, MPI_BYTE, right, 0,
+                     recv_buf + static_cast<std::size_t>(recv_ind) * block, block, MPI_BYTE, left, 0,
+                     comm, MPI_STATUS_IGNORE);
+    }
+}
+
+inline void allgather_recursive_doubling(const char* send_buf, int block, char* recv_buf, MPI_Comm comm, int proc_rank, int proc_num)
+{
+    std::memcpy(recv_buf + static_cast<std::size_t>(proc_rank) * block, send_buf, block);
+    for (int mask = 1; mask < proc_num; mask <<= 1)
+    {
+        // после шага mask у процесса есть mask блоков, начиная с (rank & ~(mask-1)); обмен с партнёром rank ^ mask
+        int partner = proc_rank ^ mask;
+        int my_start = proc_rank & ~(mask - 1);
+        int partner_start = partner & ~(mask - 1);
+        MPI_Sendrecv(recv_buf + static_cast<std::size_t>(my_start) * block, mask * block, MPI_BYTE, partner, 0,
+                     recv_buf + static_cast<std::size_t>(partner_start) * block, mask * block, MPI_BYTE, partner, 0,
+                     comm, MPI_STATUS_IGNORE);
+    }
+}
+
+inline void allgather_bruck(const char* send_buf, int block, char* recv_buf, MPI_Comm comm, int proc_rank, int proc_num)
+{
+    // во временном буфере блок i принадлежит процессу (rank + i) % p
+    std::vector<char> tmp(static_cast<std::size_t>(proc_num) * block);
+    std::memcpy(tmp.data(), send_buf, block);
+
+    for (int pof2 = 1; pof2 < proc_num; pof2 <<= 1)
+    {
+        int blocks = std::min(pof2, proc_num - pof2);
+        int dest = (proc_rank - pof2 + proc_num) % proc_num;
+        int src = (proc_rank + pof2) % proc_num;
+        MPI_Sendrecv(tmp.data(), blocks * block, MPI_BYTE, dest, 0,
+                     tmp.data() + static_cast<std::size_t>(pof2) * block, blocks * block, MPI_BYTE, src, 0,
+                     comm, MPI_STATUS_IGNORE);
+    }
+
+    // циклический сдвиг на rank блоков
+    for (int i = 0; i < proc_num; i++)
+    {
+        int owner = (proc_rank + i) % proc_num;
+        std::memcpy(recv_buf + static_cast<std::size_t>(owner) * block, tmp.data() + static_cast<std::size_t>(i) * block, block);
+    }
+}
+
+template <typename T>
+void allgather(const T* send_buf, int count, T* recv_buf, MPI_Comm comm, AllgatherAlgo algo)
+{
+    int proc_num, proc_rank;
+    MPI_Comm_rank(comm, &proc_rank);
+    MPI_Comm_size(comm, &proc_num);
+
+    const int block = count * static_cast<int>(sizeof(T)); // размер блока одного процесса в байтах
+    const char* send_bytes = reinterpret_cast<const char*>(send_buf);
+    char* recv_bytes = reinterpret_cast<char*>(recv_buf);
+
+    if (algo == AllgatherAlgo::RECURSIVE_DOUBLING && (proc_num & (proc_num - 1)) != 0)
+    {
+        algo = AllgatherAlgo::BRUCK; // удвоение определено только для степени двойки
+    }
+
+    switch (algo)
+    {
+        case AllgatherAlgo::RING:
+            allgather_ring(send_bytes, block, recv_bytes, comm, proc_rank, proc_num);
+            break;
+        case AllgatherAlgo::RECURSIVE_DOUBLING:
+            allgather_recursive_doubling(send_bytes, block, recv_bytes, comm, proc_rank, proc_num);
+            break;
+        case AllgatherAlgo::BRUCK:
+            allgather_bruck(send_bytes, block, recv_bytes, comm, proc_rank, proc_num);
+            break;
+        default:
+            MPI_Allgather(send_bytes, block, MPI_BYTE, recv_bytes, block, MPI_BYTE, comm);
+            break;
+    }
+}
@@ -0,0 +1,213 @@
+#pragma once
+
+#include <mpi.h>
+#include <algorithm>
+#include <climits>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+
+// Общий замерщик для программ mpi/:
+// прогревочные запуски, старт по MPI_Barrier, N замеров, время замера - максимум по процессам (MPI_Reduce),
+// статистика min/median/p95, прогоны по списку размеров (strong / weak scaling) и вывод в CSV.
+//
+// Параметры командной строки (удаляются из argv, остальные аргументы программы разбираются как раньше):
+//   --bench              включить режим замеров
+//   --warmup=N           прогревочных запусков (по умолчанию 3)
+//   --reps=N             замеров (по умолчанию 10)
+//   --scaling=strong     sizes - общее количество элементов
+//   --scaling=weak       sizes - количество элементов на процесс, общее = size * proc_num
+//   --sizes=a,b,c        список размеров (по умолчанию - размер из аргументов программы);
+//                        общее количество элементов (при weak - size * размер MPI_COMM_WORLD) не больше INT_MAX
+//   --csv=file           дописывать результаты в файл (по умолчанию stdout)
+struct BenchConfig
+{
+    bool enabled = false;
+    int warmup = 3;
+    int reps = 10;
+    bool weak = false;
+    std::vector<long long> sizes;
+    std::string csv;
+};
+
+struct BenchStats
+{
+    double min = 0, median = 0, p95 = 0, mean = 0; // секунды, заполнены только на нулевом процессе
+};
+
+// разбор --опций (после MPI_Init); false и сообщение в error, если опция неизвестна или значение некорректно
+inline bool parse_bench_args(int& argc, char** argv, BenchConfig& config, std::string& error)
+{
+    int kept = 1;
+    for (int i = 1; i < argc; i++)
+    {
+        std::string arg = argv[i];
+        if (arg.compare(0, 2, "--") != 0)
+        {
+            argv[kept++] = argv[i];
+            continue;
+        }
+
+        std::string key = arg.substr(2, arg.find('=') - 2);
+        std::string value = (arg.find('=') == std::string::npos) ? "" : arg.substr(arg.find('=') + 1);
+
+        if (key == "bench")
+        {
+            config.enabled = true;
+        }
+        else if (key == "warmup")
+        {
+            config.warmup = std::atoi(value.c_str());
+        }
+        else if (key == "reps")
+        {
+            config.reps = std::atoi(value.c_str());
+        }
+        else if (key == "scaling" && (value == "strong" || value == "weak"))
+        {
+            config.weak = (value == "weak");
+        }
+        else if (key == "sizes")
+        {
+            std::size_t start = 0;
+            while (start < value.size())
+            {
+                std::size_t end = value.find(',', start);
+                if (end == std::string::npos)
+                {
+                    end = value.size();
+                }
+                long long size = std::atoll(value.substr(start, end - start).c_str());
+                if (size < 1)
+                {
+                    error = "Error: sizes must be greater than or equal to 1.";
+                    return false;
+                }
+                config.sizes.push_back(size);
+                start = end + 1;
+            }
+        }
+        else if (key == "csv" && !value.empty())
+        {
+            config.csv = value;
+        }
+        else
+        {
+            error = "Error: unknown option " + arg + ".";
+            return false;
+        }
+    }
+    argv[kept] = nullptr;
+    argc = kept;
+
+    if (config.warmup < 0 || config.reps < 1)
+    {
+        error = "Error: warmup must be >= 0 and reps must be >= 1.";
+        return false;
+    }
+
+    // программы хранят размер массива в int
+    int proc_num = 1;
+    if (config.weak)
+    {
+        MPI_Comm_size(MPI_COMM_WORLD, &proc_num);
+    }
+    for (long long size : config.sizes)
+    {
+        if (size > INT_MAX / proc_num)
+        {
+            error = "Error: total size " + std::to_string(size) + (config.weak ? " * " + std::to_string(proc_num) : "")
+                  + " exceeds " + std::to_string(INT_MAX) + " elements.";
+            return false;
+        }
+    }
+    return true;
+}
+
+// общее количество элементов для каждого прогона
+inline std::vector<long long> bench_sizes(const BenchConfig& config, int proc_num, long long default_size)
+{
+    std::vector<long long> sizes = config.sizes.empty() ? std::vector<long long>{default_size} : config.sizes;
+    if (config.weak)
+    {
+        for (long long& size : sizes)
+        {
+            size *= proc_num;
+        }
+    }
+    return sizes;
+}
+
+// статистика по непустому набору замеров
+inline BenchStats bench_stats(std::vector<double> times)
+{
+    BenchStats stats;
+    std::sort(times.begin(), times.end());
+    stats.min = times.front();
+    stats.median = times[times.size() / 2];
+    stats.p95 = times[std::min(times.size() - 1, (times.size() * 95 + 99) / 100 - 1)]; // по ближайшему рангу
+    for (double t : times)
+    {
+        stats.mean += t;
+    }
+    stats.mean /= times.size();
+    return stats;
+}
+
+// замер body(): warmup прогревочных запусков, затем reps запусков, каждый начинается после MPI_Barrier.
+// Время запуска - максимум по процессам comm, статистика считается на нулевом процессе.
+template <typename F>
+BenchStats bench_run(MPI_Comm comm, const BenchConfig& config, F&& body)
+{
+    int proc_rank;
+    MPI_Comm_rank(comm, &proc_rank);
+
+    for (int i = 0; i < config.warmup; i++)
+    {
+        body();
+    }
+
+    std::vector<double> times;
+    for (int i = 0; i < config.reps; i++)
+    {
+        MPI_Barrier(comm);
+        double start_time = MPI_Wtime();
+        body();
+        double local_time = MPI_Wtime() - start_time, max_time = 0;
+        MPI_Reduce(&local_time, &max_time, 1, MPI_DOUBLE, MPI_MAX, 0, comm);
+        times.push_back(max_time);
+    }
+
+    return (proc_rank == 0) ? bench_stats(times) : BenchStats();
+}
+
+// строка CSV; заголовок выводится перед первой строкой, если файл пуст (или вывод в stdout)
+inline void bench_csv(const BenchConfig& config, const std::string& program, const std::string& mode,
+                      int proc_num, long long elems, const BenchStats& stats)
+{
+    static bool header_written = false;
+
+    std::ofstream file;
+    if (!config.csv.empty())
+    {
+        file.open(config.csv, std::ios::app);
+        if (!file.is_open())
+        {
+            std::cerr << "Error opening file " << config.csv << std::endl;
+            return;
+        }
+        header_written = header_written || file.tellp() > 0;
+    }
+    std::ostream& out = config.csv.empty() ? std::cout : file;
+
+    if (!header_written)
+    {
+        out << "program,mode,scaling,procs,elems,elems_per_proc,reps,min_s,median_s,p95_s,mean_s" << std::endl;
+        header_written = true;
+    }
+    out << program << "," << mode << "," << (config.weak ? "weak" : "strong") << ","
+        << proc_num << "," << elems << "," << elems / proc_num << "," << config.reps << ","
+        << stats.min << "," << stats.median << "," << stats.p95 << "," << stats.mean << std::endl;
+}
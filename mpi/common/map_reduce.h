@@ -0,0 +1,388 @@
+#pragma once
+
+#include <mpi.h>
+#include <algorithm>
+#include <functional>
+#include <string>
+#include <vector>
+#include "mpi_type.h"
+
+// Распределенный map/reduce над массивом элементов типа T.
+// Map - функтор T -> T, применяемый к каждому элементу, Reduce - ассоциативная и коммутативная бинарная операция.
+// Функторы передаются параметрами шаблона, поэтому ядра map_range / map_reduce_range встраиваются компилятором
+// для каждой комбинации типов, а тип MPI выбирается через mpi_type<T>.
+
+// способ распределения данных
+enum class Distribution
+{
+    BLOCKING,    // нулевой процесс рассылает фрагменты MPI_Send и собирает результаты MPI_Recv
+    NONBLOCKING, // то же через MPI_Isend / MPI_Irecv, все пересылки нулевого процесса идут одновременно
+    COLLECTIVE   // MPI_Scatterv по всем процессам (включая нулевой) и MPI_Reduce
+};
+
+inline const char* distribution_name(Distribution distribution)
+{
+    switch (distribution)
+    {
+        case Distribution::NONBLOCKING: return "nonblocking";
+        case Distribution::COLLECTIVE: return "collective";
+        default: return "blocking";
+    }
+}
+
+// разбор имени способа распределения из командной строки; false, если имя неизвестно
+inline bool parse_distribution(const std::string& name, Distribution& distribution)
+{
+    for (Distribution d : {Distribution::BLOCKING, Distribution::NONBLOCKING, Distribution::COLLECTIVE})
+    {
+        if (name == distribution_name(d))
+        {
+            distribution = d;
+            return true;
+        }
+    }
+    return false;
+}
+
+// тождественное отображение (map для чистой редукции)
+struct Identity
+{
+    template <typename T>
+    T operator()(const T& x) const { return x; }
+};
+
+// прибавление константы (map программы joker)
+template <typename T>
+struct AddConst
+{
+    T value;
+    T operator()(const T& x) const { return x + value; }
+};
+
+// применение map ко всем элементам [data, data + len)
+template <typename T, typename Map>
+inline void map_range(T* data, int len, Map map)
+{
+    for (int i = 0; i < len; i++)
+    {
+        data[i] = map(data[i]);
+    }
+}
+
+// свертка reduce(init, map(data[0]), map(data[1]), ...)
+template <typename T, typename Map, typename Reduce>
+inline T map_reduce_range(const T* data, int len, T init, Map map, Reduce reduce)
+{
+    T acc = init;
+    for (int i = 0; i < len; i++)
+    {
+        acc = reduce(acc, map(data[i]));
+    }
+    return acc;
+}
+
+// MPI_Op для Reduce: встроенная операция, если она есть, иначе пользовательская через MPI_Op_create.
+// identity() - нейтральный элемент, с которого начинаются локальные свертки.
+// Пользовательский Reduce должен создаваться конструктором по умолчанию (функтор без состояния),
+// и для него нейтральным считается T(); если это не так, нужна специализация ReduceOp.
+template <typename T, typename Reduce>
+struct ReduceOp
+{
+    static const bool builtin = false;
+    static T identity() { return T(); }
+
+    static void apply(void* in, void* inout, int* len, MPI_Datatype*)
+    {
+        const T* a = static_cast<const T*>(in);
+        T* b = static_cast<T*>(inout);
+        Reduce reduce;
+        for (int i = 0; i < *len; i++)
+        {
+            b[i] = reduce(a[i], b[i]);
+        }
+    }
+
+    static MPI_Op create()
+    {
+        MPI_Op op;
+        MPI_Op_create(&apply, 1, &op);
+        return op;
+    }
+};
+
+template <typename T>
+struct ReduceOp<T, std::plus<T>>
+{
+    static const bool builtin = true;
+    static T identity() { return T(0); }
+    static MPI_Op create() { return MPI_SUM; }
+};
+
+template <typename T>
+struct ReduceOp<T, std::multiplies<T>>
+{
+    static const bool builtin = true;
+    static T identity() { return T(1); }
+    static MPI_Op create() { return MPI_PROD; }
+};
+
+// границы фрагмента процесса rank при делении len элементов на parts частей (первые len % parts частей длиннее на 1)
+inline void block_range(int len, int parts, int rank, int& offset, int& count)
+{
+    count = len / parts + (rank < len % parts ? 1 : 0);
+    offset = rank * (len / parts) + std::min(rank, len % parts);
+}
+
+// Распределенный map: num[i] = map(num[i]) на нулевом процессе. Вызывается всеми процессами comm; num нужен только нулевому.
+// fragments - длины фрагментов от начала num (одинаковы на всех процессах): фрагмент i обрабатывает процесс order[i],
+// остаток массива после розданных фрагментов обрабатывает нулевой процесс. Пустой fragments - деление block_range
+// (BLOCKING и NONBLOCKING - между процессами 1..min(p-1, num_len), COLLECTIVE - между всеми процессами).
+// order - перестановка процессов 1..k, k = min(fragments.size(), p-1), нужна только нулевому; пустой - по порядку.
+// Длину фрагмента рабочий процесс узнает из сообщения (MPI_Probe), отдельно она не пересылается.
+// BLOCKING: MPI_Send / MPI_Recv; при any_source результаты принимаются в порядке готовности (MPI_ANY_SOURCE).
+// NONBLOCKING: все фрагменты отправляются MPI_Isend, нулевой процесс обрабатывает остаток, пока они идут.
+// COLLECTIVE: MPI_Scatterv / MPI_Gatherv, нулевой процесс - один из участников.
+template <typename T, typename Map>
+void distributed_map(std::vector<T>& num, int num_len, Map map, Distribution distribution,
+                     const std::vector<int>& fragments = {}, const std::vector<int>& order = {},
+                     bool any_source = false, MPI_Comm comm = MPI_COMM_WORLD)
+{
+    int proc_num, proc_rank;
+    MPI_Comm_rank(comm, &proc_rank);
+    MPI_Comm_size(comm, &proc_num);
+    const MPI_Datatype type = mpi_type<T>::get();
+
+    if (proc_num == 1)
+    {
+        map_range(num.data(), num_len, map);
+        return;
+    }
+
+    // рабочие процессы должны знать только свое участие, длину фрагмента они узнают из сообщения
+    const bool collective = (distribution == Distribution::COLLECTIVE);
+    int working_procs;
+    if (fragments.empty())
+    {
+        working_procs = collective ? proc_num - 1 : std::min(proc_num - 1, num_len);
+    }
+    else
+    {
+        working_procs = std::min(static_cast<int>(fragments.size()), proc_num - 1);
+    }
+
+    if (proc_rank == 0)
+    {
+        // фрагмент i: [offsets[i], offsets[i] + lengths[i]) обрабатывает процесс dests[i];
+        // [tail, tail + tail_len) обрабатывает нулевой процесс
+        std::vector<int> dests(working_procs), offsets(working_procs), lengths(working_procs);
+        int tail = num_len, tail_len = 0;
+        if (fragments.empty())
+        {
+            const int parts = collective ? proc_num : working_procs;
+            const int first = collective ? 1 : 0; // в COLLECTIVE первый блок достается нулевому процессу
+            for (int i = 0; i < working_procs; i++)
+            {
+                block_range(num_len, parts, i + first, offsets[i], lengths[i]);
+            }
+            if (collective)
+            {
+                block_range(num_len, parts, 0, tail, tail_len);
+            }
+        }
+        else
+        {
+            int offset = 0;
+            for (int i = 0; i < working_procs; i++)
+            {
+                offsets[i] = offset;
+                lengths[i] = fragments[i];
+                offset += fragments[i];
+            }
+            tail = offset;
+            tail_len = num_len - offset;
+        }
+        for (int i = 0; i < working_procs; i++)
+        {
+            dests[i] = order.empty() ? i + 1 : order[i];
+        }
+
+        if (collective)
+        {
+            std::vector<int> counts(proc_num), displs(proc_num);
+            counts[0] = tail_len;
+            displs[0] = tail;
+            for (int i = 0; i < working_procs; i++)
+            {
+                counts[dests[i]] = lengths[i];
+                displs[dests[i]] = offsets[i];
+            }
+            int count;
+            MPI_Scatter(counts.data(), 1, MPI_INT, &count, 1, MPI_INT, 0, comm);
+            MPI_Scatterv(num.data(), counts.data(), displs.data(), type, MPI_IN_PLACE, 0, type, 0, comm);
+            map_range(num.data() + tail, tail_len, map);
+            MPI_Gatherv(MPI_IN_PLACE, 0, type, num.data(), counts.data(), displs.data(), type, 0, comm);
+            return;
+        }
+
+        std::vector<MPI_Request> requests(working_procs);
+        for (int i = 0; i < working_procs; i++)
+        {
+            if (distribution == Distribution::NONBLOCKING)
+            {
+                MPI_Isend(num.data() + offsets[i], lengths[i], type, dests[i], 0, comm, &requests[i]);
+            }
+            else
+            {
+                MPI_Send(num.data() + offsets[i], lengths[i], type, dests[i], 0, comm);
+            }
+        }
+        map_range(num.data() + tail, tail_len, map);
+
+        if (distribution == Distribution::NONBLOCKING)
+        {
+            // прием в num возможен только после завершения отправок из него
+            MPI_Waitall(working_procs, requests.data(), MPI_STATUSES_IGNORE);
+            for (int i = 0; i < working_procs; i++)
+            {
+                MPI_Irecv(num.data() + offsets[i], lengths[i], type, dests[i], 0, comm, &requests[i]);
+            }
+            MPI_Waitall(working_procs, requests.data(), MPI_STATUSES_IGNORE);
+        }
+        else if (any_source)
+        {
+            std::vector<int> fragment_of(proc_num); // номер фрагмента процесса
+            for (int i = 0; i < working_procs; i++)
+            {
+                fragment_of[dests[i]] = i;
+            }
+            for (int i = 0; i < working_procs; i++)
+            {
+                MPI_Status status;
+                MPI_Probe(MPI_ANY_SOURCE, 0, comm, &status);
+                int j = fragment_of[status.MPI_SOURCE];
+                MPI_Recv(num.data() + offsets[j], lengths[j], type, status.MPI_SOURCE, 0, comm, MPI_STATUS_IGNORE);
+            }
+        }
+        else
+        {
+            for (int i = 0; i < working_procs; i++)
+            {
+                MPI_Recv(num.data() + offsets[i], lengths[i], type, dests[i], 0, comm, MPI_STATUS_IGNORE);
+            }
+        }
+    }
+    else if (collective)
+    {
+        int count;
+        MPI_Scatter(nullptr, 1, MPI_INT, &count, 1, MPI_INT, 0, comm);
+        std::vector<T> local_chunk(count);
+        MPI_Scatterv(nullptr, nullptr, nullptr, type, local_chunk.data(), count, type, 0, comm);
+        map_range(local_chunk.data(), count, map);
+        MPI_Gatherv(local_chunk.data(), count, type, nullptr, nullptr, nullptr, type, 0, comm);
+    }
+    else if (proc_rank <= working_procs)
+    {
+        MPI_Status status;
+        int count;
+        MPI_Probe(0, 0, comm, &status);
+        MPI_Get_count(&status, type, &count);
+        std::vector<T> local_chunk(count);
+        MPI_Recv(local_chunk.data(), count, type, 0, 0, comm, MPI_STATUS_IGNORE);
+        map_range(local_chunk.data(), count, map);
+        MPI_Send(local_chunk.data(), count, type, 0, 0, comm);
+    }
+}
+
+// Вызывается всеми процессами comm; num нужен только нулевому, результат возвращается только на нем.
+// Результат - reduce(init, map(num[0]), ...): init учитывается один раз на нулевом процессе,
+// локальные свертки процессов начинаются с нейтрального элемента ReduceOp<T, Reduce>::identity().
+// BLOCKING и NONBLOCKING: нулевой процесс только распределяет данные, считают процессы 1..min(p-1, num_len).
+// COLLECTIVE: считают все процессы.
+template <typename T, typename Map, typename Reduce>
+T distributed_map_reduce(const std::vector<T>& num, int num_len, T init, Map map, Reduce reduce,
+                         Distribution distribution, MPI_Comm comm = MPI_COMM_WORLD)
+{
+    int proc_num, proc_rank;
+    MPI_Comm_rank(comm, &proc_rank);
+    MPI_Comm_size(comm, &proc_num);
+    const MPI_Datatype type = mpi_type<T>::get();
+    const T identity = ReduceOp<T, Reduce>::identity();
+
+    if (proc_num == 1)
+    {
+        return map_reduce_range(num.data(), num_len, init, map, reduce);
+    }
+
+    T result = identity;
+
+    if (distribution == Distribution::COLLECTIVE)
+    {
+        std::vector<int> counts(proc_num), displs(proc_num);
+        for (int i = 0; i < proc_num; i++)
+        {
+            block_range(num_len, proc_num, i, displs[i], counts[i]);
+        }
+
+        std::vector<T> local_chunk(counts[proc_rank]);
+        MPI_Scatterv(num.data(), counts.data(), displs.data(), type,
+                     local_chunk.data(), counts[proc_rank], type, 0, comm);
+        T local = map_reduce_range(local_chunk.data(), counts[proc_rank], identity, map, reduce);
+
+        MPI_Op op = ReduceOp<T, Reduce>::create();
+        MPI_Reduce(&local, &result, 1, type, op, 0, comm);
+        if (!ReduceOp<T, Reduce>::builtin)
+        {
+            MPI_Op_free(&op);
+        }
+        return (proc_rank == 0) ? reduce(init, result) : result;
+    }
+
+    const int working_procs = std::min(proc_num - 1, num_len);
+
+    if (proc_rank == 0)
+    {
+        std::vector<T> partials(working_procs);
+        if (distribution == Distribution::NONBLOCKING)
+        {
+            std::vector<MPI_Request> requests(2 * working_procs);
+            for (int i = 0; i < working_procs; i++)
+            {
+                int offset, count;
+                block_range(num_len, working_procs, i, offset, count);
+                MPI_Isend(num.data() + offset, count, type, i + 1, 0, comm, &requests[i]);
+                MPI_Irecv(&partials[i], 1, type, i + 1, 0, comm, &requests[working_procs + i]);
+            }
+            MPI_Waitall(requests.size(), requests.data(), MPI_STATUSES_IGNORE);
+        }
+        else
+        {
+            for (int i = 0; i < working_procs; i++)
+            {
+                int offset, count;
+                block_range(num_len, working_procs, i, offset, count);
+                MPI_Send(num.data() + offset, count, type, i + 1, 0, comm);
+            }
+            for (int i = 0; i < working_procs; i++)
+            {
+                MPI_Recv(&partials[i], 1, type, i + 1, 0, comm, MPI_STATUS_IGNORE);
+            }
+        }
+
+        result = init;
+        for (const T& partial : partials)
+        {
+            result = reduce(result, partial);
+        }
+    }
+    else if (proc_rank <= working_procs)
+    {
+        int offset, count;
+        block_range(num_len, working_procs, proc_rank - 1, offset, count);
+        std::vector<T> local_chunk(count);
+        MPI_Recv(local_chunk.data(), count, type, 0, 0, comm, MPI_STATUS_IGNORE);
+        T local = map_reduce_range(local_chunk.data(), count, identity, map, reduce);
+        MPI_Send(&local, 1, type, 0, 0, comm);
+    }
+
+    return result;
+}
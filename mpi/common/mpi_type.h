@@ -0,0 +1,19 @@
+#pragma once
+
+#include <mpi.h>
+
+// Соответствие типа C++ и MPI_Datatype на этапе компиляции: mpi_type<T>::get().
+// Для типа без специализации компиляция завершается ошибкой (неполный тип).
+// Константы MPI_Datatype в некоторых реализациях не являются constexpr, поэтому значение возвращается функцией.
+template <typename T>
+struct mpi_type;
+
+template <> struct mpi_type<char> { static MPI_Datatype get() { return MPI_CHAR; } };
+template <> struct mpi_type<int> { static MPI_Datatype get() { return MPI_INT; } };
+template <> struct mpi_type<unsigned> { static MPI_Datatype get() { return MPI_UNSIGNED; } };
+template <> struct mpi_type<long> { static MPI_Datatype get() { return MPI_LONG; } };
+template <> struct mpi_type<unsigned long> { static MPI_Datatype get() { return MPI_UNSIGNED_LONG; } };
+template <> struct mpi_type<long long> { static MPI_Datatype get() { return MPI_LONG_LONG; } };
+template <> struct mpi_type<unsigned long long> { static MPI_Datatype get() { return MPI_UNSIGNED_LONG_LONG; } };
+template <> struct mpi_type<float> { static MPI_Datatype get() { return MPI_FLOAT; } };
+template <> struct mpi_type<double> { static MPI_Datatype get() { return MPI_DOUBLE; } };
@@ -0,0 +1,95 @@
+#pragma once
+
+#include <mpi.h>
+#include <cstring>
+
+// Двухуровневая редукция с учётом узлов:
+// 1) коммуникатор делится на узлы через MPI_Comm_split_type(MPI_COMM_TYPE_SHARED);
+// 2) внутри узла процессы пишут свои данные в общее окно (MPI_Win_allocate_shared),
+//    лидер узла складывает их прямо в памяти, без пересылки сообщений;
+// 3) между узлами редукция идёт только по лидерам.
+// Результат получает ранг 0 исходного коммуникатора. Операция должна быть коммутативной (например, MPI_SUM).
+// Коммуникаторы и окно создаются один раз, поэтому объект можно использовать многократно;
+// освобождаются деструктором, поэтому объект должен быть уничтожен до MPI_Finalize.
+// Создание коллективное и не бесплатное: объект создается только там, где вызывается reduce.
+class NodeReducer
+{
+public:
+    NodeReducer(MPI_Comm comm, int count, MPI_Datatype type);
+    NodeReducer(const NodeReducer&) = delete;
+    NodeReducer& operator=(const NodeReducer&) = delete;
+    ~NodeReducer(); // освобождение окна и коммуникаторов (коллективно)
+
+    void reduce(const void* send_buf, void* recv_buf, MPI_Op op); // аналог MPI_Reduce с root = 0
+    int nodes() const { return node_count; } // количество узлов
+    int node_size() const { return node_proc_num; } // количество процессов на текущем узле
+
+private:
+    MPI_Comm node_comm;   // процессы одного узла
+    MPI_Comm leader_comm; // лидеры узлов (MPI_COMM_NULL у остальных)
+    MPI_Win win;          // общее окно узла: node_proc_num ячеек по count элементов
+    char* slots;          // начало общего окна
+    int node_proc_num, node_proc_rank;
+    int node_count;
+    int count, type_size;
+    MPI_Datatype type;
+};
+
+inline NodeReducer::NodeReducer(MPI_Comm comm, int count, MPI_Datatype type)
+    : leader_comm(MPI_COMM_NULL), slots(nullptr), node_count(0), count(count), type(type)
+{
+    int proc_rank;
+    MPI_Comm_rank(comm, &proc_rank);
+    MPI_Type_size(type, &type_size);
+
+    // ключ = ранг, поэтому ранг 0 всегда лидер своего узла и ранг 0 среди лидеров
+    MPI_Comm_split_type(comm, MPI_COMM_TYPE_SHARED, proc_rank, MPI_INFO_NULL, &node_comm);
+    MPI_Comm_rank(node_comm, &node_proc_rank);
+    MPI_Comm_size(node_comm, &node_proc_num);
+
+    MPI_Comm_split(comm, node_proc_rank == 0 ? 0 : MPI_UNDEFINED, proc_rank, &leader_comm);
+    if (leader_comm != MPI_COMM_NULL)
+    {
+        MPI_Comm_size(leader_comm, &node_count);
+    }
+    MPI_Bcast(&node_count, 1, MPI_INT, 0, node_comm);
+
+    // вся память окна выделяется у лидера, остальные получают на неё указатель
+    MPI_Aint win_size = (node_proc_rank == 0) ? static_cast<MPI_Aint>(node_proc_num) * count * type_size : 0;
+    char* base;
+    MPI_Win_allocate_shared(win_size, type_size, MPI_INFO_NULL, node_comm, &base, &win);
+
+    MPI_Aint size;
+    int disp_unit;
+    MPI_Win_shared_query(win, 0, &size, &disp_unit, &slots);
+}
+
+inline NodeReducer::~NodeReducer()
+{
+    MPI_Win_free(&win);
+    if (leader_comm != MPI_COMM_NULL)
+    {
+        MPI_Comm_free(&leader_comm);
+    }
+    MPI_Comm_free(&node_comm);
+}
+
+inline void NodeReducer::reduce(const void* send_buf, void* recv_buf, MPI_Op op)
+{
+    const std::size_t bytes = static_cast<std::size_t>(count) * type_size;
+
+    // первый fence гарантирует, что лидер закончил читать окно в предыдущем вызове
+    MPI_Win_fence(0, win);
+    std::memcpy(slots + node_proc_rank * bytes, send_buf, bytes);
+    MPI_Win_fence(0, win);
+
+    if (node_proc_rank == 0)
+    {
+        // свёртка ячеек узла в ячейку лидера
+        for (int i = 1; i < node_proc_num; i++)
+        {
+            MPI_Reduce_local(slots + i * bytes, slots, count, type, op);
+        }
+        MPI_Reduce(slots, recv_buf, count, type, op, 0, leader_comm);
+    }
+}
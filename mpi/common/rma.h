@@ -0,0 +1,157 @@
+#pragma once
+
+#include <mpi.h>
+#include <string>
+#include "mpi_type.h"
+
+// Односторонние операции (RMA) для схем "нулевой процесс - рабочие":
+// нулевой процесс открывает свой массив окном MPI_Win_create, рабочие сами читают фрагменты (MPI_Get)
+// и записывают результаты (MPI_Put / MPI_Accumulate). Нулевой процесс не выставляет приемов
+// и не копирует результаты - он только участвует в синхронизации.
+//
+// Синхронизация:
+//   FENCE   - активная цель: MPI_Win_fence на всех процессах после чтений и после записей;
+//   PASSIVE - пассивная цель: MPI_Win_lock_all на все время жизни окна, рабочие завершают свои операции
+//             MPI_Win_flush, нулевой процесс только ждет MPI_Barrier после записей.
+// Окно создается один раз и используется многократно; освобождается явным вызовом free() до MPI_Finalize.
+
+enum class RmaSync
+{
+    FENCE,
+    PASSIVE
+};
+
+// имя режима в командной строке программ
+inline const char* rma_sync_name(RmaSync sync)
+{
+    return (sync == RmaSync::FENCE) ? "rma_fence" : "rma_passive";
+}
+
+// разбор имени режима; false, если имя неизвестно
+inline bool parse_rma_sync(const std::string& name, RmaSync& sync)
+{
+    for (RmaSync s : {RmaSync::FENCE, RmaSync::PASSIVE})
+    {
+        if (name == rma_sync_name(s))
+        {
+            sync = s;
+            return true;
+        }
+    }
+    return false;
+}
+
+// окно над массивом из count элементов типа T на нулевом процессе comm; смещения - в элементах
+template <typename T>
+class RootWindow
+{
+public:
+    RootWindow(T* base, int count, RmaSync sync, MPI_Comm comm); // коллективно; base и count нужны только нулевому
+    RootWindow(const RootWindow&) = delete;
+    RootWindow& operator=(const RootWindow&) = delete;
+
+    void get(T* dest, int offset, int count);                       // чтение с нулевого процесса
+    void put(const T* src, int offset, int count);                  // запись на нулевой процесс
+    void accumulate(const T* src, int offset, int count, MPI_Op op); // атомарное объединение с данными нулевого процесса
+    void fetched();  // вызывается всеми процессами после get: прочитанные данные доступны
+    void complete(); // вызывается всеми процессами после put / accumulate: данные видны на нулевом процессе
+    void stored();   // вызывается нулевым процессом после записи в свою память окна: запись видна операциям следующих шагов
+    void free();     // освобождение окна
+
+private:
+    MPI_Win win;
+    MPI_Comm comm;
+    MPI_Datatype type;
+    RmaSync sync;
+    int proc_rank;
+};
+
+template <typename T>
+inline RootWindow<T>::RootWindow(T* base, int count, RmaSync sync, MPI_Comm comm)
+    : comm(comm), type(mpi_type<T>::get()), sync(sync)
+{
+    MPI_Comm_rank(comm, &proc_rank);
+
+    MPI_Aint win_size = (proc_rank == 0) ? static_cast<MPI_Aint>(count) * sizeof(T) : 0;
+    MPI_Win_create(proc_rank == 0 ? base : nullptr, win_size, sizeof(T), MPI_INFO_NULL, comm, &win);
+
+    if (sync == RmaSync::FENCE)
+    {
+        MPI_Win_fence(0, win); // открытие первой эпохи доступа
+    }
+    else
+    {
+        MPI_Win_lock_all(0, win);
+    }
+}
+
+template <typename T>
+inline void RootWindow<T>::get(T* dest, int offset, int count)
+{
+    MPI_Get(dest, count, type, 0, offset, count, type, win);
+}
+
+template <typename T>
+inline void RootWindow<T>::put(const T* src, int offset, int count)
+{
+    MPI_Put(src, count, type, 0, offset, count, type, win);
+}
+
+template <typename T>
+inline void RootWindow<T>::accumulate(const T* src, int offset, int count, MPI_Op op)
+{
+    MPI_Accumulate(src, count, type, 0, offset, count, type, op, win);
+}
+
+template <typename T>
+inline void RootWindow<T>::fetched()
+{
+    if (sync == RmaSync::FENCE)
+    {
+        MPI_Win_fence(0, win);
+    }
+    else if (proc_rank != 0)
+    {
+        MPI_Win_flush_local(0, win); // нулевой процесс в чтениях рабочих не участвует
+    }
+}
+
+template <typename T>
+inline void RootWindow<T>::complete()
+{
+    if (sync == RmaSync::FENCE)
+    {
+        MPI_Win_fence(0, win);
+        return;
+    }
+
+    if (proc_rank != 0)
+    {
+        MPI_Win_flush(0, win); // записи завершены на нулевом процессе
+    }
+    MPI_Barrier(comm);
+    MPI_Win_sync(win); // согласование памяти окна с локальными чтениями и записями нулевого процесса
+}
+
+template <typename T>
+inline void RootWindow<T>::stored()
+{
+    if (sync == RmaSync::PASSIVE)
+    {
+        MPI_Win_sync(win); // в режиме FENCE запись упорядочивает следующий MPI_Win_fence
+    }
+}
+
+template <typename T>
+inline void RootWindow<T>::free()
+{
+    if (sync == RmaSync::PASSIVE)
+    {
+        MPI_Win_unlock_all(win);
+    }
+    else
+    {
+        MPI_Win_fence(MPI_MODE_NOSUCCEED, win);
+    }
+    MPI_Win_free(&win);
+}
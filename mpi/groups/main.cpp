@@ -1,6 +1,13 @@
 #include <mpi.h>
 #include <iostream>
 #include <vector>
+#include <string>
+#include <iomanip>
+#include <cstdlib>
+#include "../common/allgather.h"
+#include "../common/bench.h"
+
+void bench_allgather(MPI_Comm, int, int, int, const BenchConfig&);
 
 int main(int argc, char* argv[])
 {
@@ -11,6 +18,31 @@ int main(int argc, char* argv[])
     MPI_Comm_rank(MPI_COMM_WORLD, &world_proc_rank);
     MPI_Comm_size(MPI_COMM_WORLD, &world_proc_num);
 
+    BenchConfig bench_config; // параметры замеров (--bench, --reps=N, ...), см. common/bench.h
+    std::string error;
+    if (!parse_bench_args(argc, argv, bench_config, error))
+    {
+        if (world_proc_rank == 0)
+        {
+            std::cerr << error << std::endl;
+        }
+        MPI_Finalize();
+        return 1;
+    }
+
+    // имя алгоритма Allgather (native, ring, recursive_doubling, bruck) или bench - сравнение всех алгоритмов
+    std::string mode = (argc > 1) ? argv[1] : "native";
+    AllgatherAlgo algo = AllgatherAlgo::NATIVE;
+    if (mode != "bench" && !parse_allgather_algo(mode, algo))
+    {
+        if (world_proc_rank == 0)
+        {
+            std::cerr << "Error: unknown mode " << mode << " (native, ring, recursive_doubling, bruck, bench)." << std::endl;
+        }
+        MPI_Finalize();
+        return 1;
+    }
+
     float numbers[2]; // две вещественных числа у нечетных процессов
     if (world_proc_rank % 2 == 1) 
     {
@@ -35,7 +67,34 @@ int main(int argc, char* argv[])
     MPI_Comm odd_comm; // новый коммуникатор на основе извелеченной группы и глобального коммуникатора
     MPI_Comm_create(MPI_COMM_WORLD, odd_group, &odd_comm);
 
-    if (odd_comm != MPI_COMM_NULL) // если процесс принадлежит к созданному выше коммуникатору
+    if (mode == "bench")
+    {
+        int max_count = (argc > 2) ? std::atoi(argv[2]) : (1 << 16); // максимальное количество float от одного процесса
+        bench_allgather(odd_comm, world_proc_rank, world_proc_num, std::max(max_count, 1), bench_config);
+    }
+    else if (bench_config.enabled && world_proc_num > 1)
+    {
+        // замер выбранного алгоритма на odd_comm; размеры - общее количество float, собираемое каждым процессом
+        const int odd_num = world_proc_num / 2;
+        for (long long size : bench_sizes(bench_config, odd_num, 2 * odd_num))
+        {
+            const int count = std::max(1, static_cast<int>(size / odd_num));
+            std::vector<float> send(count, static_cast<float>(world_proc_rank));
+            std::vector<float> recv(static_cast<std::size_t>(count) * odd_num);
+            BenchStats stats = bench_run(MPI_COMM_WORLD, bench_config, [&]
+            {
+                if (odd_comm != MPI_COMM_NULL)
+                {
+                    allgather(send.data(), count, recv.data(), odd_comm, algo);
+                }
+            });
+            if (world_proc_rank == 0)
+            {
+                bench_csv(bench_config, "groups", allgather_name(algo), odd_num, static_cast<long long>(count) * odd_num, stats);
+            }
+        }
+    }
+    else if (odd_comm != MPI_COMM_NULL) // если процесс принадлежит к созданному выше коммуникатору
     {
         int odd_proc_num, odd_proc_rank; // количество процессов и ранг в созданном коммуникаторе
         MPI_Comm_rank(odd_comm, &odd_proc_rank);
@@ -45,7 +104,7 @@ int main(int argc, char* argv[])
         std::vector<float> all_numbers(2 * odd_proc_num);
 
         // Каждому нечетному процессу пересылаются все вещественные числа
-        MPI_Allgather(numbers, 2, MPI_FLOAT, all_numbers.data(), 2, MPI_FLOAT, odd_comm);
+        allgather(numbers, 2, all_numbers.data(), odd_comm, algo);
 
         end_time = MPI_Wtime();
         if (world_proc_rank == 1) 
@@ -73,4 +132,130 @@ int main(int argc, char* argv[])
     MPI_Finalize();
 
     return 0;
-}
\ No newline at end of file
+}
+
+// замер всех алгоритмов Allgather: размер сообщения от 1 до max_count float на процесс (шаг x4),
+// коммуникаторы из первых 2, 4, 8, ... процессов MPI_COMM_WORLD, весь MPI_COMM_WORLD и odd_comm.
+// Время - медиана bench_run (common/bench.h) по bench_config.reps запускам, как у остальных замеров;
+// выводит нулевой процесс MPI_COMM_WORLD.
+// recursive_doubling на коммуникаторе, размер которого не степень двойки, выполнялся бы как bruck,
+// поэтому там он не замеряется ("-" в таблице) и в выборе победителя не участвует.
+void bench_allgather(MPI_Comm odd_comm, int world_proc_rank, int world_proc_num, int max_count, const BenchConfig& bench_config)
+{
+    std::vector<std::pair<std::string, MPI_Comm>> comms; // подпись и коммуникатор (MPI_COMM_NULL, если процесс не входит)
+    std::vector<int> comm_sizes;
+    for (int size = 2; size < world_proc_num * 2; size *= 2)
+    {
+        size = std::min(size, world_proc_num);
+        MPI_Comm prefix_comm;
+        MPI_Comm_split(MPI_COMM_WORLD, world_proc_rank < size ? 0 : MPI_UNDEFINED, world_proc_rank, &prefix_comm);
+        comms.emplace_back("first_" + std::to_string(size), prefix_comm);
+        comm_sizes.push_back(size);
+    }
+    comms.emplace_back("odd", odd_comm);
+    comm_sizes.push_back(world_proc_num / 2);
+
+    const int algo_num = sizeof(all_allgather_algos) / sizeof(all_allgather_algos[0]);
+    if (world_proc_rank == 0)
+    {
+        std::cout << std::left << std::setw(12) << "comm" << std::setw(8) << "procs" << std::setw(12) << "bytes";
+        for (AllgatherAlgo algo : all_allgather_algos)
+        {
+            std::cout << std::setw(20) << allgather_name(algo);
+        }
+        std::cout << "winner" << std::endl;
+    }
+
+    for (std::size_t c = 0; c < comms.size(); c++)
+    {
+        MPI_Comm comm = comms[c].second;
+        if (comm_sizes[c] < 2)
+        {
+            continue;
+        }
+        const bool power_of_two = (comm_sizes[c] & (comm_sizes[c] - 1)) == 0;
+        bool skipped[algo_num];
+        for (int a = 0; a < algo_num; a++)
+        {
+            skipped[a] = (all_allgather_algos[a] == AllgatherAlgo::RECURSIVE_DOUBLING && !power_of_two);
+        }
+
+        for (int count = 1; count <= max_count; count *= 4)
+        {
+            double times[algo_num] = {}, max_times[algo_num];
+            int errors = 0, total_errors = 0;
+
+            if (comm != MPI_COMM_NULL)
+            {
+                int proc_rank, proc_num;
+                MPI_Comm_rank(comm, &proc_rank);
+                MPI_Comm_size(comm, &proc_num);
+                std::vector<float> send(count, static_cast<float>(proc_rank));
+                std::vector<float> recv(static_cast<std::size_t>(count) * proc_num);
+
+                for (int a = 0; a < algo_num; a++)
+                {
+                    if (skipped[a])
+                    {
+                        continue;
+                    }
+                    std::fill(recv.begin(), recv.end(), -1.0f);
+                    allgather(send.data(), count, recv.data(), comm, all_allgather_algos[a]); // проверка
+                    for (std::size_t i = 0; i < recv.size(); i++)
+                    {
+                        if (recv[i] != static_cast<float>(i / count))
+                        {
+                            errors++;
+                            break;
+                        }
+                    }
+
+                    BenchStats stats = bench_run(comm, bench_config, [&]
+                    {
+                        allgather(send.data(), count, recv.data(), comm, all_allgather_algos[a]);
+                    });
+                    times[a] = stats.median; // только у нулевого процесса comm, у остальных 0
+                }
+            }
+
+            // медиана известна нулевому процессу comm (для odd_comm это не нулевой процесс MPI_COMM_WORLD)
+            MPI_Reduce(times, max_times, algo_num, MPI_DOUBLE, MPI_MAX, 0, MPI_COMM_WORLD);
+            MPI_Reduce(&errors, &total_errors, 1, MPI_INT, MPI_SUM, 0, MPI_COMM_WORLD);
+
+            if (world_proc_rank == 0)
+            {
+                int best = 0; // native замеряется всегда
+                std::cout << std::left << std::setw(12) << comms[c].first << std::setw(8) << comm_sizes[c]
+                          << std::setw(12) << count * sizeof(float);
+                for (int a = 0; a < algo_num; a++)
+                {
+                    if (skipped[a])
+                    {
+                        std::cout << std::setw(20) << "-";
+                        continue;
+                    }
+                    std::cout << std::setw(20) << max_times[a];
+                    if (max_times[a] < max_times[best])
+                    {
+                        best = a;
+                    }
+                }
+                std::cout << allgather_name(all_allgather_algos[best]);
+                if (total_errors > 0)
+                {
+                    std::cout << " (errors: " << total_errors << ")";
+                }
+                std::cout << std::endl;
+            }
+        }
+    }
+
+    // odd_comm освобождается в main
+    for (std::size_t c = 0; c + 1 < comms.size(); c++)
+    {
+        if (comms[c].second != MPI_COMM_NULL)
+        {
+            MPI_Comm_free(&comms[c].second);
+        }
+    }
+}
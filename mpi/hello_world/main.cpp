@@ -1,60 +1,226 @@
 #include <iostream>
+#include <iomanip>
+#include <chrono>
+#include <cstring>
+#include <filesystem>
+#include <map>
+#include <string>
+#include <vector>
+#include <sched.h>
+#include <unistd.h>
 #include "mpi.h"
 
 using namespace std;
 
+const int MAX_CPUS = 1024; // максимальный номер ядра в маске привязки
+const int HOST_LEN = 64;
+
+// Запись о размещении процесса. Размер фиксирован, поэтому все записи собираются одним MPI_Gather
+struct RankInfo
+{
+    int rank;
+    int cpu;             // ядро, на котором процесс выполняется в момент опроса (sched_getcpu)
+    int numa_node;       // узел NUMA этого ядра, -1 если неизвестно
+    int bound_cpus;      // количество ядер в маске привязки
+    double startup_time; // время от входа в main до готовности (MPI_Init, опрос размещения), секунды
+    char host[HOST_LEN];
+    unsigned char cpu_mask[MAX_CPUS / 8]; // маска привязки (sched_getaffinity), бит i - ядро i
+};
+
+RankInfo collect_info(int, chrono::steady_clock::time_point);
+int numa_node_of(int);
+string mask_to_string(const unsigned char*);
+void print_placement(const vector<RankInfo>&);
+
 int main(int argc, char* argv[])
 {
-    double start_time, end_time;
+    auto main_start = chrono::steady_clock::now(); // MPI_Wtime недоступен до MPI_Init
 
-    int proc_num, proc_rank, recv_rank;
-    // количество процессов, ранг текущего процесса, ранг возвращаемого процесса
-    MPI_Status Status;
-    //структуру данных с информацией о результате выполнения операции приема данных
-    MPI_Init(&argc, &argv); 
+    int proc_num, proc_rank;
+    // количество процессов, ранг текущего процесса
+    MPI_Init(&argc, &argv);
     // Параметрами функции являются количество аргументов в командной строке и текст самой командной строки
     // Сложный тип аргументов MPI_Init предусмотрен для того, чтобы передавать всем процессам аргументы main
 
-    start_time = MPI_Wtime(); 
-
     MPI_Comm_size(MPI_COMM_WORLD, &proc_num); // получение количества параллельных процессов в коммуникаторе:
     MPI_Comm_rank(MPI_COMM_WORLD, &proc_rank); // получение ранга (номера) процесса в коммуникаторе comm в диапазоне от 0 до proc_num-1
     // MPI_COMM_WORLD создается по умолчанию и представляет все процессы выполняемой параллельной программы
 
+    RankInfo info = collect_info(proc_rank, main_start);
+
+    double start_time = MPI_Wtime();
+
+    vector<RankInfo> all_info;
+    if (proc_rank == 0)
+    {
+        all_info.resize(proc_num);
+    }
+    // Записи всех процессов собираются на нулевом одним коллективным вызовом:
+    // реализации MPI выполняют MPI_Gather деревом, поэтому число шагов растет как log(proc_num),
+    // а не как proc_num последовательных MPI_Recv
+    MPI_Gather(&info, sizeof(RankInfo), MPI_BYTE, all_info.data(), sizeof(RankInfo), MPI_BYTE, 0, MPI_COMM_WORLD);
+
+    double total_time = MPI_Wtime() - start_time;
+    MPI_Finalize(); // Последней вызываемой функцией MPI обязательно должна являться функция MPI_Finalize
+
     if (proc_rank == 0)
     {
-        cout << "\n Hello from process " << proc_rank;
-        for (int i=1; i<proc_num; i++) 
+        print_placement(all_info);
+        cout << "\nGather time: " << total_time << " seconds\n";
+    }
+
+    return 0;
+}
+
+// опрос размещения текущего процесса
+RankInfo collect_info(int proc_rank, chrono::steady_clock::time_point main_start)
+{
+    RankInfo info;
+    memset(&info, 0, sizeof(info));
+
+    info.rank = proc_rank;
+    info.cpu = sched_getcpu();
+    info.numa_node = (info.cpu >= 0) ? numa_node_of(info.cpu) : -1;
+
+    gethostname(info.host, HOST_LEN - 1);
+
+    cpu_set_t cpu_set;
+    CPU_ZERO(&cpu_set);
+    if (sched_getaffinity(0, sizeof(cpu_set), &cpu_set) == 0)
+    {
+        for (int i = 0; i < MAX_CPUS && i < CPU_SETSIZE; i++)
+        {
+            if (CPU_ISSET(i, &cpu_set))
+            {
+                info.cpu_mask[i / 8] |= 1 << (i % 8);
+                info.bound_cpus++;
+            }
+        }
+    }
+
+    info.startup_time = chrono::duration<double>(chrono::steady_clock::now() - main_start).count();
+    return info;
+}
+
+// номер узла NUMA ядра cpu: в /sys/devices/system/cpu/cpuN есть ссылка nodeK
+int numa_node_of(int cpu)
+{
+    error_code ec;
+    filesystem::path dir = "/sys/devices/system/cpu/cpu" + to_string(cpu);
+    for (const auto& entry : filesystem::directory_iterator(dir, ec))
+    {
+        string name = entry.path().filename().string();
+        if (name.compare(0, 4, "node") == 0 && name.size() > 4 && isdigit(name[4]))
         {
-            MPI_Recv(&recv_rank, 1, MPI_INT, i, MPI_ANY_TAG, MPI_COMM_WORLD, &Status);
-            //первые три – аналогично MPI_Send
-            //ранг процесса, от которого должен быть выполнен прием сообщения
-            //тег (идентификатор) сообщения, которое должно быть принято для процесса
-            //коммуникатор, в рамках которого выполняется передача данных
-            //указатель на структуру данных с информацией о результате выполнения операции приема данных
-            cout << "\n Hello from process " << recv_rank; 
-        } 
+            return stoi(name.substr(4));
+        }
     }
-    else
+    return -1;
+}
+
+// маска привязки в виде списка диапазонов, например "0-3,8"
+string mask_to_string(const unsigned char* mask)
+{
+    string result;
+    for (int i = 0; i < MAX_CPUS; i++)
     {
-        // Сообщение, отправляемое всеми процессами, кроме процесса с рангом 0
-        MPI_Send(&proc_rank, 1, MPI_INT, 0, 0, MPI_COMM_WORLD);
-        //адрес буфера памяти, в котором располагаются данные отправляемого сообщения
-        //количество элементов данных в сообщении (не байт!)
-        //тип элементов данных пересылаемого сообщения
-        //ранг процесса, которому отправляется сообщение (от 0 до (proc_num-1))
-        //значение-тег, используемое для идентификации сообщений (целое неотрицательное число)
-        //коммуникатор, в рамках которого выполняется передача данных
+        if (!(mask[i / 8] & (1 << (i % 8))))
+        {
+            continue;
+        }
+        int j = i;
+        while (j + 1 < MAX_CPUS && (mask[(j + 1) / 8] & (1 << ((j + 1) % 8))))
+        {
+            j++;
+        }
+        result += (result.empty() ? "" : ",") + to_string(i) + (j > i ? "-" + to_string(j) : "");
+        i = j;
     }
+    return result.empty() ? "-" : result;
+}
 
-    end_time = MPI_Wtime(); 
-    double total_time = end_time - start_time;
-    MPI_Finalize(); // Последней вызываемой функцией MPI обязательно должна являться функция MPI_Finalize
+// карта размещения и предупреждения о переподписке ядер
+void print_placement(const vector<RankInfo>& all_info)
+{
+    cout << left << setw(6) << "rank" << setw(24) << "host" << setw(6) << "cpu" << setw(6) << "numa"
+         << setw(24) << "binding" << "startup, s" << "\n";
+    for (const RankInfo& info : all_info)
+    {
+        cout << left << setw(6) << info.rank << setw(24) << info.host << setw(6) << info.cpu << setw(6) << info.numa_node
+             << setw(24) << mask_to_string(info.cpu_mask) << info.startup_time << "\n";
+    }
 
-    if (proc_rank == 0)
+    // группировка процессов по узлам
+    map<string, vector<const RankInfo*>> hosts;
+    for (const RankInfo& info : all_info)
+    {
+        hosts[info.host].push_back(&info);
+    }
+
+    bool problems = false;
+    cout << "\nHosts:\n";
+    for (const auto& [host, ranks] : hosts)
     {
-        cout << "\nTotal execution time: " << total_time << " seconds\n";
+        map<int, vector<int>> pinned; // ядро -> процессы, привязанные только к нему
+        unsigned char available[MAX_CPUS / 8] = {}; // объединение масок привязки процессов узла
+        int unbound = 0;
+        double max_startup = 0;
+
+        for (const RankInfo* info : ranks)
+        {
+            for (int i = 0; i < MAX_CPUS / 8; i++)
+            {
+                available[i] |= info->cpu_mask[i];
+            }
+            if (info->bound_cpus == 1)
+            {
+                for (int i = 0; i < MAX_CPUS; i++)
+                {
+                    if (info->cpu_mask[i / 8] & (1 << (i % 8)))
+                    {
+                        pinned[i].push_back(info->rank);
+                    }
+                }
+            }
+            else
+            {
+                unbound++;
+            }
+            max_startup = max(max_startup, info->startup_time);
+        }
+
+        int cores = 0;
+        for (int i = 0; i < MAX_CPUS; i++)
+        {
+            cores += (available[i / 8] & (1 << (i % 8))) ? 1 : 0;
+        }
+
+        cout << " " << host << ": " << ranks.size() << " processes, " << cores << " cores available ("
+             << mask_to_string(available) << "), slowest startup " << max_startup << " s\n";
+
+        for (const auto& [cpu, cpu_ranks] : pinned)
+        {
+            if (cpu_ranks.size() > 1)
+            {
+                problems = true;
+                cout << "  WARNING: core " << cpu << " is oversubscribed by ranks";
+                for (int rank : cpu_ranks)
+                {
+                    cout << " " << rank;
+                }
+                cout << "\n";
+            }
+        }
+        if (static_cast<int>(ranks.size()) > cores)
+        {
+            problems = true;
+            cout << "  WARNING: " << ranks.size() << " processes share " << cores << " cores\n";
+        }
+        if (unbound > 0)
+        {
+            cout << "  NOTE: " << unbound << " processes are not bound to a single core and may migrate\n";
+        }
     }
 
-    return 0; 
+    cout << (problems ? "\nPlacement check FAILED\n" : "\nPlacement check passed\n");
 }
@@ -4,20 +4,71 @@
 #include <numeric>
 #include <algorithm> 
 #include <random>   
+#include <string>
+#include <memory>
+#include "../common/bench.h"
+#include "../common/map_reduce.h"
+#include "../common/rma.h"
+
+// постоянные запросы (MPI_Send_init / MPI_Recv_init) для многошаговой обработки массива.
+// У нулевого процесса два набора запросов: на четных шагах фрагменты отправляются из buffers[0] и принимаются в buffers[1],
+// на нечетных - наоборот, поэтому буфер отправки не изменяется, пока запрос активен.
+template <typename T>
+struct PersistentMap
+{
+    std::vector<MPI_Request> requests[2]; // у рабочих используется только requests[0]: прием и отправка фрагмента
+    std::vector<T> buffers[2];            // массив на нулевом процессе
+    std::vector<T> local_chunk;           // фрагмент рабочего процесса
+    int offset = 0;                       // начало хвоста, который нулевой процесс обрабатывает сам
+    int num_len = 0;
+    int step = 0;
+};
+
+// Обработка односторонними операциями (common/rma.h): num нулевого процесса открыт окном,
+// рабочий процесс i читает фрагмент get_fragments(num_len)[i - 1] (MPI_Get), обрабатывает и записывает
+// обратно (MPI_Put). Смещения фрагментов известны всем процессам заранее, поэтому, в отличие от
+// shuffled_map, фрагменты закреплены за процессами по порядку, без перемешивания и без пересылки длин.
+template <typename T>
+struct RmaMap
+{
+    std::unique_ptr<RootWindow<T>> window;
+    std::vector<T> local_chunk; // фрагмент рабочего процесса
+    T* num = nullptr;           // массив на нулевом процессе
+    int offset = 0;             // у рабочего - начало фрагмента, у нулевого - начало хвоста, который он обрабатывает сам
+    int num_len = 0;
+};
 
-void plus(std::vector<int>&, int, int);
 std::vector<int> get_fragments(int);
+std::vector<int> shuffled_procs(int);
+template <typename T, typename Map> void shuffled_map(std::vector<T>&, int, Map, Distribution, int, int);
+template <typename T> void persistent_map_init(PersistentMap<T>&, const std::vector<T>&, int, int, int);
+template <typename T, typename Map> void persistent_map_step(PersistentMap<T>&, Map, int);
+template <typename T> void persistent_map_free(PersistentMap<T>&, std::vector<T>&, int);
+template <typename T> void rma_map_init(RmaMap<T>&, std::vector<T>&, int, RmaSync, int, int);
+template <typename T, typename Map> void rma_map_step(RmaMap<T>&, Map, int);
+template <typename T> void rma_map_free(RmaMap<T>&);
 
 int main(int argc, char* argv[]) 
 {
     MPI_Init(&argc, &argv);
 
     int proc_num, proc_rank;
-    MPI_Status Status;
 
     MPI_Comm_rank(MPI_COMM_WORLD, &proc_rank);
     MPI_Comm_size(MPI_COMM_WORLD, &proc_num); 
 
+    BenchConfig bench_config; // параметры замеров (--bench, --reps=N, ...), см. common/bench.h
+    std::string error;
+    if (!parse_bench_args(argc, argv, bench_config, error))
+    {
+        if (proc_rank == 0) 
+        {
+            std::cerr << error << std::endl;
+        }
+        MPI_Finalize();
+        return 1;
+    }
+
     int num_len;
 
     if (argc < 2)
@@ -28,10 +79,27 @@ int main(int argc, char* argv[])
     {
         num_len = std::atoi(argv[1]);
     }
+    // p2p (= blocking), nonblocking, collective - пересылки на каждом шаге через distributed_map (common/map_reduce.h),
+    // persistent - постоянные запросы, rma_fence / rma_passive - односторонние операции
+    std::string mode = (argc > 2) ? argv[2] : "p2p";
+    int steps = (argc > 3) ? std::atoi(argv[3]) : 1; // количество шагов: на каждом шаге ко всем элементам прибавляется 1
+
+    RmaSync sync;
+    Distribution distribution = Distribution::BLOCKING; // p2p
+    if (mode != "p2p" && mode != "persistent" && !parse_distribution(mode, distribution) && !parse_rma_sync(mode, sync))
+    {
+        if (proc_rank == 0) 
+        {
+            std::cerr << "Error: unknown mode " << mode
+                      << " (p2p, blocking, nonblocking, collective, persistent, rma_fence, rma_passive)." << std::endl;
+        }
+        MPI_Finalize();
+        return 1;
+    }
 
     if (num_len < 1)
     {
-        if (proc_rank == 0)
+        if (proc_rank == 0) 
         {
             std::cerr << "Error: Array size must be greater than or equal to 1." << std::endl;
         }
@@ -39,76 +107,306 @@ int main(int argc, char* argv[])
         return 1;
     }
 
+    if (steps < 1)
+    {
+        if (proc_rank == 0) 
+        {
+            std::cerr << "Error: Number of steps must be greater than or equal to 1." << std::endl;
+        }
+        MPI_Finalize();
+        return 1;
+    }
+
     std::vector<int> num;  
+    const AddConst<int> map{1}; // обработка элемента: прибавление 1 (ядро встраивается через common/map_reduce.h)
+
+    if (bench_config.enabled)
+    {
+        for (long long size : bench_sizes(bench_config, proc_num, num_len))
+        {
+            num_len = static_cast<int>(size);
+            if (proc_rank == 0)
+            {
+                num.resize(num_len);
+                std::iota(num.begin(), num.end(), 0);
+            }
+            BenchStats stats;
+            if (mode == "persistent")
+            {
+                // запросы создаются один раз на размер, замеряется один шаг
+                PersistentMap<int> persistent;
+                persistent_map_init(persistent, num, num_len, proc_rank, proc_num);
+                stats = bench_run(MPI_COMM_WORLD, bench_config, [&]
+                {
+                    persistent_map_step(persistent, map, proc_rank);
+                });
+                persistent_map_free(persistent, num, proc_rank);
+            }
+            else if (parse_rma_sync(mode, sync))
+            {
+                // окно создается один раз на размер, замеряется один шаг
+                RmaMap<int> rma;
+                rma_map_init(rma, num, num_len, sync, proc_rank, proc_num);
+                stats = bench_run(MPI_COMM_WORLD, bench_config, [&]
+                {
+                    rma_map_step(rma, map, proc_rank);
+                });
+                rma_map_free(rma);
+            }
+            else
+            {
+                stats = bench_run(MPI_COMM_WORLD, bench_config, [&]
+                {
+                    shuffled_map(num, num_len, map, distribution, proc_rank, proc_num);
+                });
+            }
+            if (proc_rank == 0)
+            {
+                bench_csv(bench_config, "joker", mode, proc_num, num_len, stats);
+            }
+        }
+    }
+    else
+    {
+        if (proc_rank == 0) 
+        {
+            num.resize(num_len);
+            // Начальный массив от 0 до num_len
+            std::iota(num.begin(), num.end(), 0);
+        }
+
+        double start_time = MPI_Wtime();
+        if (mode == "persistent")
+        {
+            PersistentMap<int> persistent;
+            persistent_map_init(persistent, num, num_len, proc_rank, proc_num);
+            for (int step = 0; step < steps; step++)
+            {
+                persistent_map_step(persistent, map, proc_rank);
+            }
+            persistent_map_free(persistent, num, proc_rank);
+        }
+        else if (parse_rma_sync(mode, sync))
+        {
+            RmaMap<int> rma;
+            rma_map_init(rma, num, num_len, sync, proc_rank, proc_num);
+            for (int step = 0; step < steps; step++)
+            {
+                rma_map_step(rma, map, proc_rank);
+            }
+            rma_map_free(rma);
+        }
+        else
+        {
+            for (int step = 0; step < steps; step++)
+            {
+                shuffled_map(num, num_len, map, distribution, proc_rank, proc_num);
+            }
+        }
+        double end_time = MPI_Wtime();
+
+        if (proc_rank == 0) 
+        {
+            std::cout << "Total execution time: " << end_time - start_time << " seconds" << std::endl;
+            std::cout << "Processed array: ";
+            for (int el : num) 
+            {
+                std::cout << el << " ";
+            }
+            std::cout << std::endl;
+        }
+    }
+
+    MPI_Finalize();
+    return 0;
+}
+
+// обработка фрагментов num (длины из get_fragments) случайно выбранными процессами через distributed_map.
+// Вызывается всеми процессами; num нужен только нулевому.
+template <typename T, typename Map>
+void shuffled_map(std::vector<T>& num, int num_len, Map map, Distribution distribution, int proc_rank, int proc_num)
+{
+    std::vector<int> fragments = get_fragments(num_len);
+    std::vector<int> proc_ind; // порядок рассылки, нужен только нулевому процессу
+    if (proc_rank == 0)
+    {
+        proc_ind = shuffled_procs(std::min(static_cast<int>(fragments.size()), proc_num - 1));
+    }
+    distributed_map(num, num_len, map, distribution, fragments, proc_ind);
+}
+
+// распределение фрагментов (как в shuffled_map) и создание постоянных запросов.
+// Длина фрагмента отправляется рабочему процессу один раз, на шагах пересылаются только данные.
+template <typename T>
+void persistent_map_init(PersistentMap<T>& persistent, const std::vector<T>& num, int num_len, int proc_rank, int proc_num)
+{
+    const MPI_Datatype type = mpi_type<T>::get();
     std::vector<int> fragments = get_fragments(num_len);
     const int needed_proc = fragments.size();
     const int working_procs = std::min(needed_proc, proc_num-1);
 
+    persistent.num_len = num_len;
+    persistent.step = 0;
+
     if (proc_rank == 0) 
     {
-        num.resize(num_len);
-        // Начальный массив от 0 до num_len
-        std::iota(num.begin(), num.end(), 0);
+        persistent.buffers[0] = num;
+        persistent.buffers[1] = num;
 
-        // Массив номеров процессов от 1 до working_procs
-        std::vector<int> proc_ind(working_procs);
-        std::iota(proc_ind.begin(), proc_ind.end(), 1);
-        // Перемешивание массива, mt19937 - генератор случайных чисел, std::random_device{}() - случайный сид для генератора
-        std::shuffle(proc_ind.begin(), proc_ind.end(), std::mt19937{std::random_device{}()});
+        std::vector<int> proc_ind = shuffled_procs(working_procs);
 
-        int offset = 0; // смещение для фрагмента
+        int offset = 0;
         for (int i = 0; i < working_procs; i++) 
         {
             int dest = proc_ind[i];
             int chunk_len = fragments[i];
-
             MPI_Send(&chunk_len, 1, MPI_INT, dest, 0, MPI_COMM_WORLD);  // размер фрагмента
-            MPI_Send(&num[offset], chunk_len, MPI_INT, dest, 0, MPI_COMM_WORLD);  // фрагмент
 
-            offset += chunk_len;  // Смещение на размер фрагмента
+            for (int b = 0; b < 2; b++)
+            {
+                MPI_Request request;
+                MPI_Send_init(&persistent.buffers[b][offset], chunk_len, type, dest, 0, MPI_COMM_WORLD, &request);
+                persistent.requests[b].push_back(request);
+                MPI_Recv_init(&persistent.buffers[1 - b][offset], chunk_len, type, dest, 0, MPI_COMM_WORLD, &request);
+                persistent.requests[b].push_back(request);
+            }
+            offset += chunk_len;
         }
+        persistent.offset = offset;
+    }
+    else if (proc_rank <= working_procs)
+    {
+        int chunk_len;
+        MPI_Recv(&chunk_len, 1, MPI_INT, 0, 0, MPI_COMM_WORLD, MPI_STATUS_IGNORE);  // размер фрагмента
+        persistent.local_chunk.resize(chunk_len);
+        persistent.requests[0].resize(2);
+        MPI_Recv_init(persistent.local_chunk.data(), chunk_len, type, 0, 0, MPI_COMM_WORLD, &persistent.requests[0][0]);
+        MPI_Send_init(persistent.local_chunk.data(), chunk_len, type, 0, 0, MPI_COMM_WORLD, &persistent.requests[0][1]);
+    }
+}
+
+// один шаг: нулевой процесс запускает все пересылки сразу (MPI_Startall) и, пока они идут, обрабатывает хвост
+template <typename T, typename Map>
+void persistent_map_step(PersistentMap<T>& persistent, Map map, int proc_rank)
+{
+    if (proc_rank == 0) 
+    {
+        const int cur = persistent.step % 2;
+        std::vector<MPI_Request>& requests = persistent.requests[cur];
+        std::vector<T>& next = persistent.buffers[1 - cur];
 
-        if (offset < num_len) // если процессов не хватило
+        if (!requests.empty()) // при единственном процессе запросов нет
         {
-            plus(num, offset, num_len);
+            MPI_Startall(requests.size(), requests.data());
         }
-
-        offset = 0;
-        for (int i = 0; i < working_procs; i++) 
+        std::copy(persistent.buffers[cur].begin() + persistent.offset, persistent.buffers[cur].end(), next.begin() + persistent.offset);
+        map_range(next.data() + persistent.offset, persistent.num_len - persistent.offset, map);
+        if (!requests.empty())
         {
-            int chunk_len = fragments[i];
-            std::vector<int> local_chunk(chunk_len);
-            int dest = proc_ind[i];
-            MPI_Recv(local_chunk.data(), chunk_len, MPI_INT, dest, MPI_ANY_TAG, MPI_COMM_WORLD, &Status);
-            //MPI_Recv(local_chunk.data(), chunk_len, MPI_INT, MPI_ANY_SOURCE, 0, MPI_COMM_WORLD, &Status);
+            MPI_Waitall(requests.size(), requests.data(), MPI_STATUSES_IGNORE);
+        }
+    }
+    else if (!persistent.requests[0].empty())
+    {
+        MPI_Start(&persistent.requests[0][0]);
+        MPI_Wait(&persistent.requests[0][0], MPI_STATUS_IGNORE);
+        map_range(persistent.local_chunk.data(), persistent.local_chunk.size(), map);
+        MPI_Start(&persistent.requests[0][1]);
+        MPI_Wait(&persistent.requests[0][1], MPI_STATUS_IGNORE);
+    }
+    persistent.step++;
+}
 
-            // Преобразованные данные помещаются в исходную последовательность
-            std::copy(local_chunk.begin(), local_chunk.end(), num.begin() + offset);
-            offset += chunk_len;
+// освобождение запросов; результат последнего шага копируется в num на нулевом процессе
+template <typename T>
+void persistent_map_free(PersistentMap<T>& persistent, std::vector<T>& num, int proc_rank)
+{
+    for (std::vector<MPI_Request>& requests : persistent.requests)
+    {
+        for (MPI_Request& request : requests)
+        {
+            MPI_Request_free(&request);
         }
+        requests.clear();
+    }
+
+    if (proc_rank == 0) 
+    {
+        num = persistent.buffers[persistent.step % 2];
+    }
+}
+
+// создание окна над num; вызывается всеми процессами, num нужен только нулевому
+template <typename T>
+void rma_map_init(RmaMap<T>& rma, std::vector<T>& num, int num_len, RmaSync sync, int proc_rank, int proc_num)
+{
+    std::vector<int> fragments = get_fragments(num_len);
+    const int needed_proc = fragments.size();
+    const int working_procs = std::min(needed_proc, proc_num-1);
+
+    rma.num = num.data();
+    rma.num_len = num_len;
 
-        std::cout << "Processed array: ";
-        for (int el : num) 
+    if (working_procs == 0) // единственный процесс обрабатывает весь массив сам, окно не нужно
+    {
+        return;
+    }
+
+    int offset = 0;
+    for (int i = 0; i < working_procs; i++)
+    {
+        if (i + 1 == proc_rank)
         {
-            std::cout << el << " ";
+            rma.offset = offset;
+            rma.local_chunk.resize(fragments[i]);
         }
-        std::cout << std::endl;
-    } 
-    
-    else if (proc_rank <= working_procs)
+        offset += fragments[i];
+    }
+    if (proc_rank == 0) 
     {
-        int chunk_len;
-        MPI_Recv(&chunk_len, 1, MPI_INT, 0, 0, MPI_COMM_WORLD, &Status);  // размер фрагмента
-        std::vector<int> local_chunk(chunk_len);
-        MPI_Recv(local_chunk.data(), chunk_len, MPI_INT, 0, MPI_ANY_TAG, MPI_COMM_WORLD, &Status);  // фрагмент
+        rma.offset = offset;
+    }
+
+    rma.window.reset(new RootWindow<T>(num.data(), num_len, sync, MPI_COMM_WORLD));
+}
 
-        // Обрабатка фрагмента
-        plus(local_chunk, 0, chunk_len);
-        MPI_Send(local_chunk.data(), chunk_len, MPI_INT, 0, 0, MPI_COMM_WORLD);
+// один шаг: рабочие читают, обрабатывают и записывают свои фрагменты, нулевой процесс тем временем обрабатывает хвост
+template <typename T, typename Map>
+void rma_map_step(RmaMap<T>& rma, Map map, int proc_rank)
+{
+    if (!rma.window)
+    {
+        map_range(rma.num, rma.num_len, map);
+        return;
     }
 
-    MPI_Finalize();
-    return 0;
+    const bool worker = !rma.local_chunk.empty();
+    if (worker)
+    {
+        rma.window->get(rma.local_chunk.data(), rma.offset, rma.local_chunk.size());
+    }
+    rma.window->fetched();
+
+    if (proc_rank == 0) 
+    {
+        map_range(rma.num + rma.offset, rma.num_len - rma.offset, map);
+    }
+    else if (worker)
+    {
+        map_range(rma.local_chunk.data(), rma.local_chunk.size(), map);
+        rma.window->put(rma.local_chunk.data(), rma.offset, rma.local_chunk.size());
+    }
+    rma.window->complete();
+}
+
+template <typename T>
+void rma_map_free(RmaMap<T>& rma)
+{
+    if (rma.window)
+    {
+        rma.window->free();
+        rma.window.reset();
+    }
 }
 
 std::vector<int> get_fragments(int num_len)
@@ -132,10 +430,12 @@ std::vector<int> get_fragments(int num_len)
     return vec;
 }
 
-void plus(std::vector<int>& num, int start, int finish) 
+// номера процессов от 1 до count в случайном порядке
+std::vector<int> shuffled_procs(int count)
 {
-    for (start; start<finish; start++)
-    {
-        num[start]+=1;
-    }
-}
\ No newline at end of file
+    std::vector<int> proc_ind(count);
+    std::iota(proc_ind.begin(), proc_ind.end(), 1);
+    // Перемешивание массива, mt19937 - генератор случайных чисел, std::random_device{}() - случайный сид для генератора
+    std::shuffle(proc_ind.begin(), proc_ind.end(), std::mt19937{std::random_device{}()});
+    return proc_ind;
+}
@@ -4,10 +4,12 @@
 #include <numeric>
 #include <algorithm> 
 #include <random> 
-#include <unordered_map>  
+#include <string>
+#include "../common/bench.h"
+#include "../common/map_reduce.h"
 
-void plus(std::vector<int>&, int, int);
 std::vector<int> get_fragments(int);
+template <typename T, typename Map> std::vector<int> any_source_map(std::vector<T>&, int, Map, int, int);
 
 int main(int argc, char* argv[]) 
 {
@@ -16,11 +18,21 @@ int main(int argc, char* argv[])
 
     MPI_Init(&argc, &argv);
 
-    MPI_Status Status;
-
     MPI_Comm_rank(MPI_COMM_WORLD, &proc_rank);
     MPI_Comm_size(MPI_COMM_WORLD, &proc_num); 
 
+    BenchConfig bench_config; // параметры замеров (--bench, --reps=N, ...), см. common/bench.h
+    std::string error;
+    if (!parse_bench_args(argc, argv, bench_config, error))
+    {
+        if (proc_rank == 0) 
+        {
+            std::cerr << error << std::endl;
+        }
+        MPI_Finalize();
+        return 1;
+    }
+
     int num_len;
 
     if (argc < 2)
@@ -34,7 +46,7 @@ int main(int argc, char* argv[])
 
     if (num_len < 1)
     {
-        if (proc_rank == 0)
+        if (proc_rank == 0) 
         {
             std::cerr << "Error: Array size must be greater than or equal to 1." << std::endl;
         }
@@ -43,98 +55,90 @@ int main(int argc, char* argv[])
     }
 
     std::vector<int> num;  // массив 
-    std::vector<int> fragments = get_fragments(num_len); // массив вида ([num_len/2], [num_len/4],.. , 1) (длины фрагментов)
-    const int needed_proc = fragments.size();
-    const int working_procs = std::min(needed_proc, proc_num-1); // процессы, учавствующие в вычислениях
+    const AddConst<int> map{1}; // обработка элемента: прибавление 1 (ядро встраивается через common/map_reduce.h)
 
-    if (proc_rank == 0) 
+    if (bench_config.enabled)
     {
-        num.resize(num_len);
-        // Начальный массив от 0 до num_len
-        std::iota(num.begin(), num.end(), 0);
-
-        // Массив номеров процессов от 1 до working_procs
-        std::vector<int> proc_ind(working_procs);
-        std::iota(proc_ind.begin(), proc_ind.end(), 1);
-        // Перемешивание массива, mt19937 - генератор случайных чисел, std::random_device{}() - случайный сид для генератора
-        std::shuffle(proc_ind.begin(), proc_ind.end(), std::mt19937{std::random_device{}()});
-
-        int offset = 0; // смещение для фрагмента
-        start_time = MPI_Wtime(); 
-
-        for (int i = 0; i < working_procs; i++) 
-        {
-            int dest = proc_ind[i]; // какому процессу отправлять
-            int chunk_len = fragments[i]; // длина фрагмента
-
-            MPI_Send(&chunk_len, 1, MPI_INT, dest, 0, MPI_COMM_WORLD);  // размер фрагмента
-            MPI_Send(&num[offset], chunk_len, MPI_INT, dest, 0, MPI_COMM_WORLD);  // фрагмент
-
-            offset += chunk_len;  // Смещение на размер фрагмента
-        }
-
-        if (offset < num_len) // если процессов не хватило
+        for (long long size : bench_sizes(bench_config, proc_num, num_len))
         {
-            plus(num, offset, num_len);
+            num_len = static_cast<int>(size);
+            if (proc_rank == 0)
+            {
+                num.resize(num_len);
+                std::iota(num.begin(), num.end(), 0);
+            }
+            BenchStats stats = bench_run(MPI_COMM_WORLD, bench_config, [&]
+            {
+                any_source_map(num, num_len, map, proc_rank, proc_num);
+            });
+            if (proc_rank == 0)
+            {
+                bench_csv(bench_config, "joker", "any_source", proc_num, num_len, stats);
+            }
         }
-
-        std::unordered_map<int, int> hash_table; // мапа вида <размер массива> : <смещение>
-        int cur = 0;
-        for (int i = 0; i < needed_proc; i++) 
+    }
+    else
+    {
+        if (proc_rank == 0) 
         {
-            hash_table[fragments[i]] = cur;
-            cur += fragments[i];
+            num.resize(num_len);
+            // Начальный массив от 0 до num_len
+            std::iota(num.begin(), num.end(), 0);
         }
 
-        for (int i = 0; i < working_procs; i++) 
-        {
-            int chunk_len;
-            // получение размера фрагмента через джокер
-            MPI_Recv(&chunk_len, 1, MPI_INT, MPI_ANY_SOURCE, MPI_ANY_TAG, MPI_COMM_WORLD, &Status);
-            std::vector<int> local_chunk(chunk_len);
-            int dest = Status.MPI_SOURCE;
-            offset = hash_table[chunk_len];
-            // получение фрагмента
-            MPI_Recv(local_chunk.data(), chunk_len, MPI_INT, dest, MPI_ANY_TAG, MPI_COMM_WORLD, &Status);
-
-            // Преобразованные данные помещаются в исходную последовательность
-            std::copy(local_chunk.begin(), local_chunk.end(), num.begin() + offset);
-        }
+        start_time = MPI_Wtime(); 
+        std::vector<int> proc_ind = any_source_map(num, num_len, map, proc_rank, proc_num);
         end_time = MPI_Wtime();
-        std::cout << "Total execution time: " << end_time - start_time << " seconds" << std::endl;
-
-        std::cout << "Sending sequence: ";
-        for (int el : proc_ind) 
-        {
-            std::cout << el << " ";
-        }
-        std::cout << std::endl;
 
-        std::cout << "Processed array: ";
-        for (int el : num) 
+        if (proc_rank == 0) 
         {
-            std::cout << el << " ";
+            std::cout << "Total execution time: " << end_time - start_time << " seconds" << std::endl;
+
+            std::cout << "Sending sequence: ";
+            for (int el : proc_ind) 
+            {
+                std::cout << el << " ";
+            }
+            std::cout << std::endl;
+
+            std::cout << "Processed array: ";
+            for (int el : num) 
+            {
+                std::cout << el << " ";
+            }
+            std::cout << std::endl;
         }
-        std::cout << std::endl;
-    } 
-    
-    else if (proc_rank <= working_procs)
-    {
-        int chunk_len;
-        MPI_Recv(&chunk_len, 1, MPI_INT, 0, 0, MPI_COMM_WORLD, &Status);  // размер фрагмента
-        std::vector<int> local_chunk(chunk_len);
-        MPI_Recv(local_chunk.data(), chunk_len, MPI_INT, 0, MPI_ANY_TAG, MPI_COMM_WORLD, &Status);  // фрагмент
-
-        // Обрабатка фрагмента
-        plus(local_chunk, 0, chunk_len);
-        MPI_Send(&chunk_len, 1, MPI_INT, 0, 0, MPI_COMM_WORLD); // размер фрагмента
-        MPI_Send(local_chunk.data(), chunk_len, MPI_INT, 0, 0, MPI_COMM_WORLD); // фрагмент
     }
 
     MPI_Finalize();
     return 0;
 }
 
+// рассылка фрагментов num случайно выбранным процессам, сбор в порядке готовности (MPI_ANY_SOURCE) на нулевом процессе
+// через distributed_map (common/map_reduce.h). Вызывается всеми процессами; num нужен только нулевому,
+// порядок рассылки возвращается только на нем.
+template <typename T, typename Map>
+std::vector<int> any_source_map(std::vector<T>& num, int num_len, Map map, int proc_rank, int proc_num)
+{
+    std::vector<int> proc_ind; // порядок рассылки фрагментов
+
+    std::vector<int> fragments = get_fragments(num_len); // массив вида ([num_len/2], [num_len/4],.. , 1) (длины фрагментов)
+    const int needed_proc = fragments.size();
+    const int working_procs = std::min(needed_proc, proc_num-1); // процессы, учавствующие в вычислениях
+
+    if (proc_rank == 0) 
+    {
+        // Массив номеров процессов от 1 до working_procs
+        proc_ind.resize(working_procs);
+        std::iota(proc_ind.begin(), proc_ind.end(), 1);
+        // Перемешивание массива, mt19937 - генератор случайных чисел, std::random_device{}() - случайный сид для генератора
+        std::shuffle(proc_ind.begin(), proc_ind.end(), std::mt19937{std::random_device{}()});
+    }
+
+    distributed_map(num, num_len, map, Distribution::BLOCKING, fragments, proc_ind, true);
+    return proc_ind;
+}
+
 std::vector<int> get_fragments(int num_len)
 {
     std::vector<int> vec;
@@ -148,11 +152,3 @@ std::vector<int> get_fragments(int num_len)
 
     return vec;
 }
-
-void plus(std::vector<int>& num, int start, int finish) 
-{
-    for (start; start<finish; start++)
-    {
-        num[start]+=1;
-    }
-}
\ No newline at end of file
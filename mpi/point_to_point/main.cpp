@@ -2,21 +2,79 @@
 #include <iostream>
 #include <vector>
 #include <cstdlib>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <memory>
+#include "../common/node_reduce.h"
+#include "../common/bench.h"
+#include "../common/map_reduce.h"
+#include "../common/rma.h"
 
-int sum(const std::vector<int>& num);
+// постоянные запросы (MPI_Send_init / MPI_Recv_init) для многократного повторения одной и той же рассылки
+template <typename T>
+struct PersistentSum
+{
+    std::vector<MPI_Request> requests; // у нулевого: отправки фрагментов и приемы сумм, у рабочих: прием фрагмента и отправка суммы
+    std::vector<T> local_chunk;        // фрагмент рабочего процесса
+    std::vector<T> local_sums;         // локальные суммы рабочих на нулевом процессе
+    T local_sum = 0;
+    const std::vector<T>* num = nullptr;
+};
 
-int main(int argc, char* argv[]) 
+// Сбор односторонними операциями (common/rma.h): рабочие читают фрагменты из окна над num (MPI_Get)
+// и пишут локальные суммы в окно над local_sums (MPI_Put), нулевой процесс только складывает local_sums.
+// Шаги пишут суммы попеременно в две половины local_sums: в режиме rma_passive рабочие могут начать
+// следующий шаг, пока нулевой процесс еще складывает суммы предыдущего.
+// Режимы *_accumulate: вместо отдельной ячейки на рабочего все рабочие прибавляют свои суммы к одной ячейке шага
+// (MPI_Accumulate с MPI_SUM), нулевой процесс только читает и обнуляет ее
+template <typename T>
+struct RmaSum
 {
-    double start_time, end_time;
+    std::unique_ptr<RootWindow<T>> num_window;
+    std::unique_ptr<RootWindow<T>> sums_window;
+    std::vector<T> local_sums;  // на нулевом процессе: 2 * working_procs (при accumulate - 2)
+    std::vector<T> local_chunk; // фрагмент рабочего процесса
+    const std::vector<T>* num = nullptr;
+    int working_procs = 0;
+    int offset = 0;             // начало фрагмента рабочего процесса в num
+    int step = 0;
+    bool accumulate = false;
+};
 
+bool parse_rma_mode(const std::string&, RmaSync&, bool&);
+template <typename T> void run(int, const std::string&, const std::string&, int, const BenchConfig&, int, int);
+template <typename T> T sum(const T*, int);
+template <typename T> T distributed_sum(const std::vector<T>&, int, const std::string&, int, int, NodeReducer*);
+template <typename T> T node_sum(const std::vector<T>&, int, int, int, NodeReducer&);
+template <typename T> void persistent_sum_init(PersistentSum<T>&, const std::vector<T>&, int, int, int);
+template <typename T> T persistent_sum_step(PersistentSum<T>&, int);
+template <typename T> void persistent_sum_free(PersistentSum<T>&);
+template <typename T> void rma_sum_init(RmaSum<T>&, const std::vector<T>&, int, RmaSync, bool, int, int);
+template <typename T> T rma_sum_step(RmaSum<T>&, int);
+template <typename T> void rma_sum_free(RmaSum<T>&);
+
+int main(int argc, char* argv[]) 
+{
     MPI_Init(&argc, &argv);
 
     int proc_num, proc_rank;
-    MPI_Status Status;
 
     MPI_Comm_rank(MPI_COMM_WORLD, &proc_rank);
     MPI_Comm_size(MPI_COMM_WORLD, &proc_num);
 
+    BenchConfig bench_config; // параметры замеров (--bench, --reps=N, ...), см. common/bench.h
+    std::string error;
+    if (!parse_bench_args(argc, argv, bench_config, error))
+    {
+        if (proc_rank == 0) 
+        {
+            std::cerr << error << std::endl;
+        }
+        MPI_Finalize();
+        return 1;
+    }
+
     int num_len;
 
     if (argc < 2) 
@@ -27,88 +85,402 @@ int main(int argc, char* argv[])
     {
         num_len = std::atoi(argv[1]);
     }
+    // p2p (blocking), nonblocking, collective - способы распределения из common/map_reduce.h,
+    // node - двухуровневая редукция, persistent - постоянные запросы, rma_fence / rma_passive - односторонние операции,
+    // rma_fence_accumulate / rma_passive_accumulate - то же со сбором сумм через MPI_Accumulate
+    std::string mode = (argc > 2) ? argv[2] : "p2p";
+    int steps = (argc > 3) ? std::atoi(argv[3]) : 1; // количество повторений суммирования одного и того же массива
+    std::string type = (argc > 4) ? argv[4] : "int"; // тип элементов: int, int64, float, double
 
-    if (num_len < 1) 
+    Distribution distribution;
+    RmaSync sync;
+    bool accumulate;
+    if (mode != "p2p" && mode != "node" && mode != "persistent" && !parse_distribution(mode, distribution)
+        && !parse_rma_mode(mode, sync, accumulate))
+    {
+        error = "Error: unknown mode " + mode + " (p2p, blocking, nonblocking, collective, node, persistent, rma_fence, rma_passive, "
+                "rma_fence_accumulate, rma_passive_accumulate).";
+    }
+    else if (num_len < 1)
+    {
+        error = "Error: Array size must be greater than or equal to 1.";
+    }
+    else if (steps < 1)
+    {
+        error = "Error: Number of steps must be greater than or equal to 1.";
+    }
+    else if (type == "int")
+    {
+        run<int>(num_len, mode, type, steps, bench_config, proc_rank, proc_num);
+    }
+    else if (type == "int64")
+    {
+        run<std::int64_t>(num_len, mode, type, steps, bench_config, proc_rank, proc_num);
+    }
+    else if (type == "float")
+    {
+        run<float>(num_len, mode, type, steps, bench_config, proc_rank, proc_num);
+    }
+    else if (type == "double")
+    {
+        run<double>(num_len, mode, type, steps, bench_config, proc_rank, proc_num);
+    }
+    else
+    {
+        error = "Error: unknown type " + type + " (int, int64, float, double).";
+    }
+
+    if (!error.empty())
     {
         if (proc_rank == 0) 
         {
-            std::cerr << "Error: Array size must be greater than or equal to 1." << std::endl;
+            std::cerr << error << std::endl;
         }
         MPI_Finalize();
         return 1;
     }
 
-    const int working_procs = std::min(proc_num - 1, num_len);
-    const int chunk_len = (working_procs > 0) ? (num_len / working_procs) : num_len; 
-    const int left_elems = num_len - (working_procs - 1) * chunk_len;
+    MPI_Finalize();
+    return 0;
+}
 
-    std::vector<int> num;  
-    std::vector<int> local_chunk;
+// суммирование массива из единиц типа T выбранным способом (однократно, steps раз или в режиме замеров)
+template <typename T>
+void run(int num_len, const std::string& mode, const std::string& type, int steps, const BenchConfig& bench_config, int proc_rank, int proc_num)
+{
+    double start_time, end_time;
+    std::vector<T> num;
+    RmaSync sync;
+    bool accumulate;
 
-    if (proc_rank == 0) 
+    // коммуникаторы узлов и общее окно создаются до замера времени и только для режима node;
+    // освобождаются при выходе из run, до MPI_Finalize
+    std::unique_ptr<NodeReducer> node_reducer;
+    if (mode == "node")
     {
-        num.resize(num_len);
-        int total_sum = 0;
+        node_reducer.reset(new NodeReducer(MPI_COMM_WORLD, 1, mpi_type<T>::get()));
+    }
+    MPI_Barrier(MPI_COMM_WORLD);
 
-        for (int i = 0; i < num_len; i++) 
+    if (bench_config.enabled)
+    {
+        for (long long size : bench_sizes(bench_config, proc_num, num_len))
         {
-            num[i] = 1;
+            num_len = static_cast<int>(size);
+            if (proc_rank == 0)
+            {
+                num.assign(num_len, 1);
+            }
+            BenchStats stats;
+            if (mode == "persistent")
+            {
+                // запросы создаются один раз на размер, замеряется одна итерация
+                PersistentSum<T> persistent;
+                persistent_sum_init(persistent, num, num_len, proc_rank, proc_num);
+                stats = bench_run(MPI_COMM_WORLD, bench_config, [&]
+                {
+                    persistent_sum_step(persistent, proc_rank);
+                });
+                persistent_sum_free(persistent);
+            }
+            else if (parse_rma_mode(mode, sync, accumulate))
+            {
+                // окна создаются один раз на размер, замеряется один шаг
+                RmaSum<T> rma;
+                rma_sum_init(rma, num, num_len, sync, accumulate, proc_rank, proc_num);
+                stats = bench_run(MPI_COMM_WORLD, bench_config, [&]
+                {
+                    rma_sum_step(rma, proc_rank);
+                });
+                rma_sum_free(rma);
+            }
+            else
+            {
+                stats = bench_run(MPI_COMM_WORLD, bench_config, [&]
+                {
+                    distributed_sum(num, num_len, mode, proc_rank, proc_num, node_reducer.get());
+                });
+            }
+            if (proc_rank == 0)
+            {
+                bench_csv(bench_config, "point_to_point", mode + "_" + type, proc_num, num_len, stats);
+            }
+        }
+    }
+    else
+    {
+        if (proc_rank == 0) 
+        {
+            num.assign(num_len, 1);
         }
 
+        T total_sum = 0;
         start_time = MPI_Wtime(); 
-
-        if (proc_num == 1)
+        if (mode == "persistent")
         {
-            total_sum = sum(num);
+            // создание запросов входит в замер, далее каждая итерация - только MPI_Startall / MPI_Waitall
+            PersistentSum<T> persistent;
+            persistent_sum_init(persistent, num, num_len, proc_rank, proc_num);
+            for (int step = 0; step < steps; step++)
+            {
+                total_sum = persistent_sum_step(persistent, proc_rank);
+            }
+            persistent_sum_free(persistent);
         }
-        else
+        else if (parse_rma_mode(mode, sync, accumulate))
         {
-            int i;
-            for (i = 1; i < working_procs; i++) 
+            // создание окон входит в замер, как и создание постоянных запросов
+            RmaSum<T> rma;
+            rma_sum_init(rma, num, num_len, sync, accumulate, proc_rank, proc_num);
+            for (int step = 0; step < steps; step++)
             {
-                MPI_Send(&num[(i - 1) * chunk_len], chunk_len, MPI_INT, i, 0, MPI_COMM_WORLD);
+                total_sum = rma_sum_step(rma, proc_rank);
             }
-            MPI_Send(&num[(i - 1) * chunk_len], left_elems, MPI_INT, i, 0, MPI_COMM_WORLD);
-
-            for (int i = 1; i <= working_procs; i++) 
+            rma_sum_free(rma);
+        }
+        else
+        {
+            for (int step = 0; step < steps; step++)
             {
-                int local_sum = 0;
-                MPI_Recv(&local_sum, 1, MPI_INT, i, 0, MPI_COMM_WORLD, &Status);
-                total_sum += local_sum;
+                total_sum = distributed_sum(num, num_len, mode, proc_rank, proc_num, node_reducer.get());
             }
         }
-
         end_time = MPI_Wtime();
-        std::cout << "Total sum: " << total_sum << std::endl;
-        std::cout << "Total execution time: " << end_time - start_time << " seconds";
 
-    } 
+        if (proc_rank == 0) 
+        {
+            std::cout << "Total sum: " << total_sum << std::endl;
+            std::cout << "Total execution time: " << end_time - start_time << " seconds";
+        }
+    }
+}
+
+// сумма num через общий слой map/reduce или через двухуровневую редукцию (mode == "node", node_reducer не нулевой).
+// Вызывается всеми процессами; num нужен только нулевому, сумма возвращается только на нем.
+template <typename T>
+T distributed_sum(const std::vector<T>& num, int num_len, const std::string& mode, int proc_rank, int proc_num, NodeReducer* node_reducer)
+{
+    if (mode == "node")
+    {
+        return node_sum(num, num_len, proc_rank, proc_num, *node_reducer);
+    }
+
+    Distribution distribution = Distribution::BLOCKING; // p2p
+    parse_distribution(mode, distribution);
+    return distributed_map_reduce(num, num_len, T(0), Identity(), std::plus<T>(), distribution);
+}
+
+// рассылка фрагментов num рабочим процессам, локальные суммы собираются двухуровневой редукцией
+template <typename T>
+T node_sum(const std::vector<T>& num, int num_len, int proc_rank, int proc_num, NodeReducer& node_reducer)
+{
+    const MPI_Datatype type = mpi_type<T>::get();
+    const int working_procs = std::min(proc_num - 1, num_len);
+
+    T local_sum = 0; // у процессов без фрагмента (и у нулевого) остаётся 0
+    T total_sum = 0;
+
+    if (proc_num == 1)
+    {
+        return sum(num.data(), num_len);
+    }
+
+    if (proc_rank == 0) 
+    {
+        for (int i = 0; i < working_procs; i++)
+        {
+            int offset, count;
+            block_range(num_len, working_procs, i, offset, count);
+            MPI_Send(&num[offset], count, type, i + 1, 0, MPI_COMM_WORLD);
+        }
+    }
+    else if (proc_rank <= working_procs) 
+    {
+        int offset, count;
+        block_range(num_len, working_procs, proc_rank - 1, offset, count);
+        std::vector<T> local_chunk(count);
+        MPI_Recv(local_chunk.data(), count, type, 0, 0, MPI_COMM_WORLD, MPI_STATUS_IGNORE);
+        local_sum = sum(local_chunk.data(), count);
+    }
+
+    // в редукции участвуют все процессы, включая простаивающие
+    node_reducer.reduce(&local_sum, &total_sum, MPI_SUM);
+
+    return total_sum;
+}
+
+// создание постоянных запросов той же схемы рассылки, что и в distributed_map_reduce (Distribution::BLOCKING)
+template <typename T>
+void persistent_sum_init(PersistentSum<T>& persistent, const std::vector<T>& num, int num_len, int proc_rank, int proc_num)
+{
+    const MPI_Datatype type = mpi_type<T>::get();
+    const int working_procs = std::min(proc_num - 1, num_len);
+
+    persistent.num = &num;
+
+    if (proc_rank == 0) 
+    {
+        persistent.local_sums.resize(working_procs);
+        persistent.requests.resize(2 * working_procs);
+        for (int i = 0; i < working_procs; i++)
+        {
+            int offset, count;
+            block_range(num_len, working_procs, i, offset, count);
+            MPI_Send_init(&num[offset], count, type, i + 1, 0, MPI_COMM_WORLD, &persistent.requests[i]);
+            MPI_Recv_init(&persistent.local_sums[i], 1, type, i + 1, 0, MPI_COMM_WORLD, &persistent.requests[working_procs + i]);
+        }
+    }
     else if (proc_rank <= working_procs) 
     {
-        if (proc_rank == working_procs)
+        int offset, count;
+        block_range(num_len, working_procs, proc_rank - 1, offset, count);
+        persistent.local_chunk.resize(count);
+        persistent.requests.resize(2);
+        MPI_Recv_init(persistent.local_chunk.data(), count, type, 0, 0, MPI_COMM_WORLD, &persistent.requests[0]);
+        MPI_Send_init(&persistent.local_sum, 1, type, 0, 0, MPI_COMM_WORLD, &persistent.requests[1]);
+    }
+}
+
+// одна итерация: запуск всех запросов, ожидание, сумма возвращается только на нулевом процессе
+template <typename T>
+T persistent_sum_step(PersistentSum<T>& persistent, int proc_rank)
+{
+    T total_sum = 0;
+
+    if (proc_rank == 0) 
+    {
+        if (persistent.requests.empty()) // единственный процесс
+        {
+            return sum(persistent.num->data(), persistent.num->size());
+        }
+        MPI_Startall(persistent.requests.size(), persistent.requests.data());
+        MPI_Waitall(persistent.requests.size(), persistent.requests.data(), MPI_STATUSES_IGNORE);
+        total_sum = sum(persistent.local_sums.data(), persistent.local_sums.size());
+    }
+    else if (!persistent.requests.empty())
+    {
+        MPI_Start(&persistent.requests[0]);
+        MPI_Wait(&persistent.requests[0], MPI_STATUS_IGNORE);
+        persistent.local_sum = sum(persistent.local_chunk.data(), persistent.local_chunk.size());
+        MPI_Start(&persistent.requests[1]);
+        MPI_Wait(&persistent.requests[1], MPI_STATUS_IGNORE);
+    }
+
+    return total_sum;
+}
+
+template <typename T>
+void persistent_sum_free(PersistentSum<T>& persistent)
+{
+    for (MPI_Request& request : persistent.requests)
+    {
+        MPI_Request_free(&request);
+    }
+    persistent.requests.clear();
+}
+
+// режим rma_fence / rma_passive, с суффиксом _accumulate - сбор сумм через MPI_Accumulate; false, если имя неизвестно
+bool parse_rma_mode(const std::string& mode, RmaSync& sync, bool& accumulate)
+{
+    const std::string suffix = "_accumulate";
+    accumulate = mode.size() > suffix.size() && mode.compare(mode.size() - suffix.size(), suffix.size(), suffix) == 0;
+    return parse_rma_sync(accumulate ? mode.substr(0, mode.size() - suffix.size()) : mode, sync);
+}
+
+// создание окон; вызывается всеми процессами, num нужен только нулевому и не должен менять размер до rma_sum_free
+template <typename T>
+void rma_sum_init(RmaSum<T>& rma, const std::vector<T>& num, int num_len, RmaSync sync, bool accumulate, int proc_rank, int proc_num)
+{
+    rma.num = &num;
+    rma.working_procs = std::min(proc_num - 1, num_len);
+    rma.step = 0;
+    rma.accumulate = accumulate;
+
+    if (rma.working_procs == 0) // единственный процесс считает сам, окна не нужны
+    {
+        return;
+    }
+
+    if (proc_rank == 0) 
+    {
+        rma.local_sums.assign(accumulate ? 2 : 2 * rma.working_procs, 0);
+    }
+    else if (proc_rank <= rma.working_procs)
+    {
+        int count;
+        block_range(num_len, rma.working_procs, proc_rank - 1, rma.offset, count);
+        rma.local_chunk.resize(count);
+    }
+
+    // рабочие только читают num, поэтому снятие const безопасно
+    rma.num_window.reset(new RootWindow<T>(const_cast<T*>(num.data()), num_len, sync, MPI_COMM_WORLD));
+    rma.sums_window.reset(new RootWindow<T>(rma.local_sums.data(), rma.local_sums.size(), sync, MPI_COMM_WORLD));
+}
+
+// один шаг: чтение фрагментов, локальные суммы, запись сумм; сумма возвращается только на нулевом процессе
+template <typename T>
+T rma_sum_step(RmaSum<T>& rma, int proc_rank)
+{
+    if (rma.working_procs == 0) // единственный процесс
+    {
+        return sum(rma.num->data(), rma.num->size());
+    }
+
+    const int parity = rma.step++ % 2;
+    const int half = parity * rma.working_procs;
+    const bool worker = !rma.local_chunk.empty();
+
+    if (worker)
+    {
+        rma.num_window->get(rma.local_chunk.data(), rma.offset, rma.local_chunk.size());
+    }
+    rma.num_window->fetched();
+
+    T local_sum = 0;
+    if (worker)
+    {
+        local_sum = sum(rma.local_chunk.data(), rma.local_chunk.size());
+        if (rma.accumulate)
         {
-            local_chunk.resize(left_elems);
-            MPI_Recv(local_chunk.data(), left_elems, MPI_INT, 0, 0, MPI_COMM_WORLD, &Status);
-        } 
+            rma.sums_window->accumulate(&local_sum, parity, 1, MPI_SUM);
+        }
         else
         {
-            local_chunk.resize(chunk_len);  
-            MPI_Recv(local_chunk.data(), chunk_len, MPI_INT, 0, 0, MPI_COMM_WORLD, &Status);
+            rma.sums_window->put(&local_sum, half + proc_rank - 1, 1);
         }
-        int local_sum = sum(local_chunk);
-        MPI_Send(&local_sum, 1, MPI_INT, 0, 0, MPI_COMM_WORLD);
     }
+    rma.sums_window->complete();
 
-    MPI_Finalize();
-    return 0;
+    if (proc_rank != 0)
+    {
+        return T(0);
+    }
+    if (!rma.accumulate)
+    {
+        return sum(rma.local_sums.data() + half, rma.working_procs);
+    }
+    // ячейка обнуляется для шага через один; запись видна рабочим до их следующего MPI_Accumulate в нее
+    T total = rma.local_sums[parity];
+    rma.local_sums[parity] = 0;
+    rma.sums_window->stored();
+    return total;
 }
 
-int sum(const std::vector<int>& num) 
+template <typename T>
+void rma_sum_free(RmaSum<T>& rma)
 {
-    int sum = 0;
-    for (int i = 0; i < num.size(); i++) 
+    if (!rma.num_window)
     {
-        sum += num[i];
+        return;
     }
-    return sum;
+    rma.num_window->free();
+    rma.sums_window->free();
+    rma.num_window.reset();
+    rma.sums_window.reset();
+}
+
+template <typename T>
+T sum(const T* num, int len)
+{
+    return map_reduce_range(num, len, T(0), Identity(), std::plus<T>());
 }
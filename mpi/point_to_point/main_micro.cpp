@@ -0,0 +1,499 @@
+#include <mpi.h>
+#include <iostream>
+#include <iomanip>
+#include <fstream>
+#include <vector>
+#include <string>
+#include <cstdlib>
+#include <algorithm>
+#include <chrono>
+#include <thread>
+#include "../common/bench.h"
+
+// Микробенчмарки обмена точка-точка, на которых основан выбор схемы рассылки в main.cpp:
+//   pairs  - задержка ping-pong, одно- и двунаправленная пропускная способность для пар процессов
+//            внутри узла и между узлами (нулевой процесс и первый подходящий партнер)
+//   eager  - порог перехода MPI_Send от eager к rendezvous для тех же пар
+//   incast - все рабочие процессы одновременно отправляют сообщение нулевому (сбор результатов)
+//   all    - все тесты
+//
+// Аргументы: argv[1] - максимальный размер сообщения в байтах (по умолчанию 64 MiB), argv[2] - тест (по умолчанию all).
+// Размеры сообщений - степени двойки от 1 байта до максимального.
+// --warmup=N и --reps=N из common/bench.h задают количество прогревочных запусков и замеров,
+// --csv=file - файл, в который дописываются результаты.
+
+const long long DEFAULT_MAX_BYTES = 64LL << 20;
+const long long INCAST_MAX_TOTAL = 256LL << 20; // предел суммарного объема приема нулевого процесса в incast
+const int WINDOW = 64;                          // сообщений в окне при замере пропускной способности
+const double EAGER_DELAY = 0.005;               // задержка приема при определении порога eager, секунды
+
+// пара процессов для замеров: нулевой процесс и peer
+struct Pair
+{
+    int peer;
+    std::string locality; // intra или inter
+};
+
+// результат одного замера для вывода в таблицу и CSV
+struct MicroResult
+{
+    std::string test;
+    std::string locality;
+    int peer;
+    long long bytes;
+    BenchStats stats;   // время одного сообщения (latency, eager_probe) или одного окна / сбора (остальные тесты)
+    double bandwidth;   // МБ/с по медиане, 0 если не имеет смысла
+};
+
+std::vector<int> node_leaders(int);
+std::vector<Pair> find_pairs(const std::vector<int>&);
+std::vector<long long> message_sizes(long long, long long);
+int window_for(long long, long long);
+void run_pair(const Pair&, const std::string&, long long, const BenchConfig&, int, std::vector<MicroResult>&);
+void run_incast(const std::string&, long long, const BenchConfig&, int, int, std::vector<MicroResult>&);
+double ping_pong(char*, int, int, bool, int);
+double window_transfer(char*, char*, int, int, int, bool, bool);
+double eager_probe(char*, int, int, bool);
+void print_results(const std::vector<MicroResult>&, int);
+void write_csv(const BenchConfig&, const std::vector<MicroResult>&, int);
+
+int main(int argc, char* argv[])
+{
+    MPI_Init(&argc, &argv);
+
+    int proc_num, proc_rank;
+
+    MPI_Comm_rank(MPI_COMM_WORLD, &proc_rank);
+    MPI_Comm_size(MPI_COMM_WORLD, &proc_num);
+
+    BenchConfig bench_config; // используются warmup, reps и csv, см. common/bench.h
+    std::string error;
+    if (parse_bench_args(argc, argv, bench_config, error))
+    {
+        long long max_bytes = (argc > 1) ? std::atoll(argv[1]) : DEFAULT_MAX_BYTES;
+        std::string test = (argc > 2) ? argv[2] : "all";
+
+        if (max_bytes < 1 || max_bytes > (1LL << 30))
+        {
+            error = "Error: maximum message size must be between 1 and 1073741824 bytes.";
+        }
+        else if (test != "all" && test != "pairs" && test != "eager" && test != "incast")
+        {
+            error = "Error: unknown test " + test + " (all, pairs, eager, incast).";
+        }
+        else if (proc_num < 2)
+        {
+            error = "Error: at least 2 processes are required.";
+        }
+        else
+        {
+            std::vector<int> leaders = node_leaders(proc_rank);
+            std::vector<MicroResult> results; // заполняется только на нулевом процессе
+
+            if (test != "incast")
+            {
+                for (const Pair& pair : find_pairs(leaders))
+                {
+                    run_pair(pair, test, max_bytes, bench_config, proc_rank, results);
+                    MPI_Barrier(MPI_COMM_WORLD);
+                }
+            }
+            if (test == "all" || test == "incast")
+            {
+                // все процессы на узле нулевого - intra, ни одного - inter, иначе mixed
+                int same_node = std::count(leaders.begin(), leaders.end(), leaders[0]);
+                std::string locality = (same_node == proc_num) ? "intra" : (same_node == 1) ? "inter" : "mixed";
+                run_incast(locality, max_bytes, bench_config, proc_rank, proc_num, results);
+            }
+
+            if (proc_rank == 0)
+            {
+                print_results(results, proc_num);
+                if (!bench_config.csv.empty())
+                {
+                    write_csv(bench_config, results, proc_num);
+                }
+            }
+        }
+    }
+
+    if (!error.empty())
+    {
+        if (proc_rank == 0)
+        {
+            std::cerr << error << std::endl;
+        }
+        MPI_Finalize();
+        return 1;
+    }
+
+    MPI_Finalize();
+    return 0;
+}
+
+// для каждого процесса - ранг старшего процесса его узла (процессы с общей памятью, MPI_COMM_TYPE_SHARED)
+std::vector<int> node_leaders(int proc_rank)
+{
+    MPI_Comm node_comm;
+    MPI_Comm_split_type(MPI_COMM_WORLD, MPI_COMM_TYPE_SHARED, proc_rank, MPI_INFO_NULL, &node_comm);
+
+    int leader = proc_rank;
+    MPI_Bcast(&leader, 1, MPI_INT, 0, node_comm);
+    MPI_Comm_free(&node_comm);
+
+    int proc_num;
+    MPI_Comm_size(MPI_COMM_WORLD, &proc_num);
+    std::vector<int> leaders(proc_num);
+    MPI_Allgather(&leader, 1, MPI_INT, leaders.data(), 1, MPI_INT, MPI_COMM_WORLD);
+    return leaders;
+}
+
+// партнеры нулевого процесса: ближайший процесс того же узла и ближайший процесс другого узла (если есть)
+std::vector<Pair> find_pairs(const std::vector<int>& leaders)
+{
+    std::vector<Pair> pairs;
+    for (const char* locality : {"intra", "inter"})
+    {
+        for (int i = 1; i < static_cast<int>(leaders.size()); i++)
+        {
+            if ((leaders[i] == leaders[0]) == (std::string(locality) == "intra"))
+            {
+                pairs.push_back({i, locality});
+                break;
+            }
+        }
+    }
+    return pairs;
+}
+
+// степени двойки от 1 до max_bytes (и сам max_bytes, если он не степень двойки)
+std::vector<long long> message_sizes(long long max_bytes, long long limit)
+{
+    std::vector<long long> sizes;
+    for (long long bytes = 1; bytes <= std::min(max_bytes, limit); bytes *= 2)
+    {
+        sizes.push_back(bytes);
+    }
+    if (max_bytes <= limit && sizes.back() != max_bytes)
+    {
+        sizes.push_back(max_bytes);
+    }
+    return sizes;
+}
+
+// количество сообщений в окне: до WINDOW, но окно приема не больше max_bytes
+int window_for(long long bytes, long long max_bytes)
+{
+    return static_cast<int>(std::max(1LL, std::min<long long>(WINDOW, max_bytes / bytes)));
+}
+
+// замеры для пары (0, pair.peer); остальные процессы сразу выходят
+void run_pair(const Pair& pair, const std::string& test, long long max_bytes, const BenchConfig& config,
+              int proc_rank, std::vector<MicroResult>& results)
+{
+    if (proc_rank != 0 && proc_rank != pair.peer)
+    {
+        return;
+    }
+    const bool initiator = (proc_rank == 0);
+    const int peer = initiator ? pair.peer : 0;
+
+    std::vector<char> send_buf(max_bytes, 1), recv_buf(max_bytes);
+
+    // замер f warmup + reps раз; статистика имеет смысл у инициатора (и у партнера для eager_probe)
+    auto measure = [&](auto&& f)
+    {
+        for (int i = 0; i < config.warmup; i++)
+        {
+            f();
+        }
+        std::vector<double> times;
+        for (int i = 0; i < config.reps; i++)
+        {
+            times.push_back(f());
+        }
+        return bench_stats(times);
+    };
+
+    for (long long size : message_sizes(max_bytes, max_bytes))
+    {
+        if (test == "eager")
+        {
+            break;
+        }
+        const int bytes = static_cast<int>(size);
+        const int window = window_for(size, max_bytes);
+        // для коротких сообщений замер усредняется по нескольким обменам, чтобы не упираться в точность MPI_Wtime
+        const int iters = static_cast<int>(std::max(1LL, std::min(100LL, (1LL << 20) / size)));
+
+        BenchStats latency = measure([&] { return ping_pong(send_buf.data(), bytes, peer, initiator, iters); });
+        BenchStats uni = measure([&] { return window_transfer(send_buf.data(), recv_buf.data(), bytes, window, peer, initiator, false); });
+        BenchStats bi = measure([&] { return window_transfer(send_buf.data(), recv_buf.data(), bytes, window, peer, initiator, true); });
+
+        if (initiator)
+        {
+            results.push_back({"latency", pair.locality, pair.peer, size, latency, size / latency.median / 1e6});
+            results.push_back({"uni_bandwidth", pair.locality, pair.peer, size, uni, double(window) * size / uni.median / 1e6});
+            results.push_back({"bi_bandwidth", pair.locality, pair.peer, size, bi, 2.0 * window * size / bi.median / 1e6});
+        }
+    }
+
+    if (test == "pairs")
+    {
+        return;
+    }
+
+    // Порог eager: получатель откладывает MPI_Recv на EAGER_DELAY. Сообщение, отправленное по протоколу eager,
+    // буферизуется, и MPI_Send возвращается сразу; при rendezvous MPI_Send ждет приема.
+    // Порог - наибольший размер, для которого медиана MPI_Send меньше половины задержки.
+    long long threshold = 0;
+    for (long long size : message_sizes(max_bytes, max_bytes))
+    {
+        BenchStats probe = measure([&] { return eager_probe(send_buf.data(), static_cast<int>(size), peer, initiator); });
+        bool eager = probe.median < EAGER_DELAY / 2;
+        if (initiator)
+        {
+            results.push_back({"eager_probe", pair.locality, pair.peer, size, probe, 0});
+        }
+        if (!eager)
+        {
+            break;
+        }
+        threshold = size;
+    }
+    if (initiator)
+    {
+        results.push_back({"eager_limit", pair.locality, pair.peer, threshold, BenchStats(), 0});
+    }
+}
+
+// ping-pong iters раз; время в одну сторону (половина среднего времени обмена), секунды
+double ping_pong(char* buf, int bytes, int peer, bool initiator, int iters)
+{
+    double start_time = MPI_Wtime();
+    for (int i = 0; i < iters; i++)
+    {
+        if (initiator)
+        {
+            MPI_Send(buf, bytes, MPI_BYTE, peer, 0, MPI_COMM_WORLD);
+            MPI_Recv(buf, bytes, MPI_BYTE, peer, 0, MPI_COMM_WORLD, MPI_STATUS_IGNORE);
+        }
+        else
+        {
+            MPI_Recv(buf, bytes, MPI_BYTE, peer, 0, MPI_COMM_WORLD, MPI_STATUS_IGNORE);
+            MPI_Send(buf, bytes, MPI_BYTE, peer, 0, MPI_COMM_WORLD);
+        }
+    }
+    return (MPI_Wtime() - start_time) / iters / 2;
+}
+
+// Окно из window сообщений одновременно (MPI_Isend / MPI_Irecv), затем подтверждение нулевой длины.
+// Однонаправленный режим: инициатор отправляет, партнер принимает; двунаправленный: оба отправляют и принимают.
+// Все отправки окна читают один буфер, приемы идут в разные части recv_buf. Время окна, секунды.
+double window_transfer(char* send_buf, char* recv_buf, int bytes, int window, int peer, bool initiator, bool bidirectional)
+{
+    std::vector<MPI_Request> requests;
+    requests.reserve(2 * window);
+
+    double start_time = MPI_Wtime();
+    for (int i = 0; i < window; i++)
+    {
+        MPI_Request request;
+        if (bidirectional || !initiator)
+        {
+            MPI_Irecv(recv_buf + static_cast<long long>(i) * bytes, bytes, MPI_BYTE, peer, 1, MPI_COMM_WORLD, &request);
+            requests.push_back(request);
+        }
+        if (bidirectional || initiator)
+        {
+            MPI_Isend(send_buf, bytes, MPI_BYTE, peer, 1, MPI_COMM_WORLD, &request);
+            requests.push_back(request);
+        }
+    }
+    MPI_Waitall(requests.size(), requests.data(), MPI_STATUSES_IGNORE);
+
+    // окно считается переданным, когда партнер принял все сообщения
+    if (initiator)
+    {
+        MPI_Recv(nullptr, 0, MPI_BYTE, peer, 2, MPI_COMM_WORLD, MPI_STATUS_IGNORE);
+    }
+    else
+    {
+        MPI_Send(nullptr, 0, MPI_BYTE, peer, 2, MPI_COMM_WORLD);
+    }
+    return MPI_Wtime() - start_time;
+}
+
+// время MPI_Send инициатора при отложенном на EAGER_DELAY приеме, секунды
+double eager_probe(char* buf, int bytes, int peer, bool initiator)
+{
+    // синхронизация пары, чтобы задержка отсчитывалась от одного момента
+    MPI_Sendrecv(nullptr, 0, MPI_BYTE, peer, 3, nullptr, 0, MPI_BYTE, peer, 3, MPI_COMM_WORLD, MPI_STATUS_IGNORE);
+
+    double send_time = 0;
+    if (initiator)
+    {
+        double start_time = MPI_Wtime();
+        MPI_Send(buf, bytes, MPI_BYTE, peer, 4, MPI_COMM_WORLD);
+        send_time = MPI_Wtime() - start_time;
+    }
+    else
+    {
+        // sleep, а не активное ожидание: при переподписке ядер отправитель должен получить процессор
+        std::this_thread::sleep_for(std::chrono::duration<double>(EAGER_DELAY));
+        MPI_Recv(buf, bytes, MPI_BYTE, peer, 4, MPI_COMM_WORLD, MPI_STATUS_IGNORE);
+    }
+
+    // время известно только инициатору; партнеру оно нужно, чтобы одинаково решить, продолжать ли перебор размеров
+    if (initiator)
+    {
+        MPI_Send(&send_time, 1, MPI_DOUBLE, peer, 5, MPI_COMM_WORLD);
+    }
+    else
+    {
+        MPI_Recv(&send_time, 1, MPI_DOUBLE, peer, 5, MPI_COMM_WORLD, MPI_STATUS_IGNORE);
+    }
+    return send_time;
+}
+
+// Incast: все процессы, кроме нулевого, одновременно отправляют по bytes байт нулевому,
+// который заранее выставляет MPI_Irecv от каждого (как при сборе результатов рабочих в main.cpp).
+// Размер ограничен так, чтобы суммарный прием не превышал INCAST_MAX_TOTAL.
+void run_incast(const std::string& locality, long long max_bytes, const BenchConfig& config,
+                int proc_rank, int proc_num, std::vector<MicroResult>& results)
+{
+    const int workers = proc_num - 1;
+    const long long limit = INCAST_MAX_TOTAL / workers;
+
+    std::vector<char> buf;
+    if (proc_rank == 0)
+    {
+        buf.resize(std::min(max_bytes, limit) * workers);
+    }
+    else
+    {
+        buf.assign(std::min(max_bytes, limit), 1);
+    }
+
+    for (long long size : message_sizes(max_bytes, limit))
+    {
+        const int bytes = static_cast<int>(size);
+        BenchStats stats = bench_run(MPI_COMM_WORLD, config, [&]
+        {
+            if (proc_rank == 0)
+            {
+                std::vector<MPI_Request> requests(workers);
+                for (int i = 0; i < workers; i++)
+                {
+                    MPI_Irecv(buf.data() + static_cast<long long>(i) * bytes, bytes, MPI_BYTE, i + 1, 6, MPI_COMM_WORLD, &requests[i]);
+                }
+                MPI_Waitall(workers, requests.data(), MPI_STATUSES_IGNORE);
+            }
+            else
+            {
+                MPI_Send(buf.data(), bytes, MPI_BYTE, 0, 6, MPI_COMM_WORLD);
+            }
+        });
+        if (proc_rank == 0)
+        {
+            results.push_back({"incast", locality, -1, size, stats, double(workers) * size / stats.median / 1e6});
+        }
+    }
+}
+
+// таблицы по парам (intra / inter) и incast
+void print_results(const std::vector<MicroResult>& results, int proc_num)
+{
+    std::vector<std::string> sections;
+    for (const MicroResult& result : results)
+    {
+        std::string section = (result.test == "incast") ? "incast" : result.locality + " " + std::to_string(result.peer);
+        if (std::find(sections.begin(), sections.end(), section) == sections.end())
+        {
+            sections.push_back(section);
+        }
+    }
+
+    for (const std::string& section : sections)
+    {
+        bool incast = (section == "incast");
+        std::cout << "\n";
+        if (incast)
+        {
+            std::cout << "Incast: " << proc_num - 1 << " workers -> rank 0 (" << results.back().locality << "-node)\n";
+            std::cout << std::left << std::setw(12) << "bytes" << std::setw(16) << "median, us"
+                      << std::setw(16) << "p95, us" << "total MB/s\n";
+        }
+        else
+        {
+            std::cout << "Pair 0 <-> " << section.substr(section.find(' ') + 1) << " ("
+                      << section.substr(0, section.find(' ')) << "-node)\n";
+        }
+        if (!incast && std::any_of(results.begin(), results.end(), [](const MicroResult& r) { return r.test == "latency"; }))
+        {
+            std::cout << std::left << std::setw(12) << "bytes" << std::setw(16) << "latency, us"
+                      << std::setw(16) << "uni MB/s" << "bi MB/s\n";
+        }
+
+        long long eager_limit = -1;
+        for (const MicroResult& result : results)
+        {
+            std::string result_section = (result.test == "incast") ? "incast" : result.locality + " " + std::to_string(result.peer);
+            if (result_section != section)
+            {
+                continue;
+            }
+            if (result.test == "incast")
+            {
+                std::cout << std::left << std::setw(12) << result.bytes << std::setw(16) << result.stats.median * 1e6
+                          << std::setw(16) << result.stats.p95 * 1e6 << result.bandwidth << "\n";
+            }
+            else if (result.test == "latency")
+            {
+                std::cout << std::left << std::setw(12) << result.bytes << std::setw(16) << result.stats.median * 1e6;
+            }
+            else if (result.test == "uni_bandwidth")
+            {
+                std::cout << std::setw(16) << result.bandwidth;
+            }
+            else if (result.test == "bi_bandwidth")
+            {
+                std::cout << result.bandwidth << "\n";
+            }
+            else if (result.test == "eager_limit")
+            {
+                eager_limit = result.bytes;
+            }
+        }
+
+        if (eager_limit == 0)
+        {
+            std::cout << "Eager limit: below 1 byte (MPI_Send always waits for the receiver)\n";
+        }
+        else if (eager_limit > 0)
+        {
+            std::cout << "Eager limit: " << eager_limit << " bytes (MPI_Send returns before the receive is posted)\n";
+        }
+    }
+}
+
+// строки CSV; заголовок выводится, если файл пуст
+void write_csv(const BenchConfig& config, const std::vector<MicroResult>& results, int proc_num)
+{
+    std::ofstream file(config.csv, std::ios::app);
+    if (!file.is_open())
+    {
+        std::cerr << "Error opening file " << config.csv << std::endl;
+        return;
+    }
+    if (file.tellp() == 0)
+    {
+        file << "test,locality,peer,procs,bytes,reps,min_s,median_s,p95_s,mean_s,mbytes_per_s" << std::endl;
+    }
+    for (const MicroResult& result : results)
+    {
+        file << result.test << "," << result.locality << "," << result.peer << "," << proc_num << ","
+             << result.bytes << "," << config.reps << "," << result.stats.min << "," << result.stats.median << ","
+             << result.stats.p95 << "," << result.stats.mean << "," << result.bandwidth << std::endl;
+    }
+}
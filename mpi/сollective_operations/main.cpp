@@ -2,53 +2,160 @@
 #include <iostream>
 #include <vector>
 #include <numeric>
+#include <string>
+#include <algorithm>
+#include <cmath>
+#include <memory>
+#include "../common/node_reduce.h"
+#include "../common/bench.h"
+#include "../common/map_reduce.h"
+
+const int MAX_SEGMENTS = 1024;     // предел количества сегментов конвейера
+const int PROGRESS_STRIDE = 16384; // элементов между вызовами MPI_Test при суммировании сегмента
+const int PROBE_LEN = 65536;       // элементов на процесс в замерах для автоподбора количества сегментов
+const int PROBE_REPS = 5;
 
 int read_num_len(int, char**, int);
+int scatter_sum(const std::vector<int>&, int, NodeReducer*);
+int pipelined_scatter_sum(const std::vector<int>&, int, int, int);
+int tune_segments(const std::vector<int>&, int, int);
+void bench_reduce(NodeReducer&, const BenchConfig&, int, int);
+void run(const std::string&, int, const std::string&, int, const BenchConfig&, int, int);
 
 int main(int argc, char* argv[]) 
 {
-    double start_time, end_time;
     MPI_Init(&argc, &argv);
 
     int proc_num, proc_rank; // количество процессов и ранг процесса
     MPI_Comm_rank(MPI_COMM_WORLD, &proc_rank);
     MPI_Comm_size(MPI_COMM_WORLD, &proc_num);    
+
+    BenchConfig bench_config; // параметры замеров (--bench, --reps=N, ...), см. common/bench.h
+    std::string error;
+    if (!parse_bench_args(argc, argv, bench_config, error))
+    {
+        if (proc_rank == 0) 
+        {
+            std::cerr << error << std::endl;
+        }
+        MPI_Finalize();
+        return 1;
+    }
     
     int num_len = read_num_len(argc, argv, proc_rank); // длина вектора
-    const int left_elems = num_len % proc_num; // остаток от деления длины вектора на количество процессов
-    const int new_len = num_len + (left_elems == 0 ? 0 : (proc_num - left_elems)); // увеличение длины вектора, чтобы остаток был равен 0
-    const int chunk_len = new_len / proc_num; // длины отправляемых через scatter сегментов
-    
-    std::vector<int> num; // массив
+    std::string mode = (argc > 2) ? argv[2] : "flat"; // flat - MPI_Reduce, node - двухуровневая редукция, reduce - замер только редукций, pipeline - конвейер
+    std::string segments_arg = (argc > 3) ? argv[3] : "auto"; // количество сегментов конвейера или auto - подбор по замерам
+    int segments = (segments_arg == "auto") ? 0 : std::atoi(segments_arg.c_str()); // 0 - подбирается для каждого размера
 
-    if (proc_rank == 0) 
+    if (mode != "flat" && mode != "node" && mode != "pipeline" && mode != "reduce")
     {
-        num.resize(new_len, 0);
-        std::fill(num.begin(), num.begin() + num_len, 1); // заполнение массива единицами (по исходной длине)
+        if (proc_rank == 0) 
+        {
+            std::cerr << "Error: unknown mode " << mode << " (flat, node, pipeline, reduce)." << std::endl;
+        }
+        MPI_Finalize();
+        return 1;
     }
 
-    std::vector<int> local_chunk(chunk_len); // массив под сегмент
-
-    start_time = MPI_Wtime(); 
-
-    // отравление всем процессам в коммутаторе сегментов массива
-    MPI_Scatter(num.data(), chunk_len, MPI_INT, local_chunk.data(), chunk_len, MPI_INT, 0, MPI_COMM_WORLD); 
+    if (mode == "pipeline" && segments_arg != "auto" && segments < 1)
+    {
+        if (proc_rank == 0) 
+        {
+            std::cerr << "Error: number of segments must be greater than or equal to 1 (or auto)." << std::endl;
+        }
+        MPI_Finalize();
+        return 1;
+    }
+    
+    run(mode, num_len, segments_arg, segments, bench_config, proc_rank, proc_num);
 
-    int local_sum = std::accumulate(local_chunk.begin(), local_chunk.end(), 0); // высчитывание локальной суммы
+    MPI_Finalize();
+    return 0;
+}
 
-    int global_sum = 0;
-    MPI_Reduce(&local_sum, &global_sum, 1, MPI_INT, MPI_SUM, 0, MPI_COMM_WORLD); // высчитывание суммы локальных сумм, отправка ее на нулевой процесс
+// суммирование выбранным способом (однократно или в режиме замеров) либо сравнение редукций (mode == "reduce")
+void run(const std::string& mode, int num_len, const std::string& segments_arg, int segments, const BenchConfig& bench_config,
+         int proc_rank, int proc_num)
+{
+    double start_time, end_time;
+    std::vector<int> num; // массив
 
-    end_time = MPI_Wtime();
+    // коммуникаторы узлов и общее окно создаются до замера времени и только для режимов node и reduce;
+    // освобождаются при выходе из run, до MPI_Finalize
+    std::unique_ptr<NodeReducer> node_reducer;
+    if (mode == "node" || mode == "reduce")
+    {
+        node_reducer.reset(new NodeReducer(MPI_COMM_WORLD, 1, MPI_INT));
+    }
 
-    if (proc_rank == 0) 
+    if (mode == "reduce")
     {
-        std::cout << "Total execution time: " << end_time - start_time << " seconds" << std::endl;
-        std::cout << "Total sum: " << global_sum << std::endl;
+        bench_reduce(*node_reducer, bench_config, proc_rank, proc_num);
     }
+    else if (bench_config.enabled)
+    {
+        for (long long size : bench_sizes(bench_config, proc_num, num_len))
+        {
+            const int left_elems = size % proc_num;
+            const int new_len = size + (left_elems == 0 ? 0 : (proc_num - left_elems));
+            if (proc_rank == 0)
+            {
+                num.assign(new_len, 0);
+                std::fill(num.begin(), num.begin() + size, 1);
+            }
+            // подбор количества сегментов не входит в замер
+            const int size_segments = (mode != "pipeline") ? 1 : (segments > 0) ? segments : tune_segments(num, new_len / proc_num, proc_num);
+            BenchStats stats = bench_run(MPI_COMM_WORLD, bench_config, [&]
+            {
+                if (mode == "pipeline")
+                {
+                    pipelined_scatter_sum(num, new_len / proc_num, size_segments, proc_num);
+                }
+                else
+                {
+                    scatter_sum(num, new_len / proc_num, node_reducer.get());
+                }
+            });
+            if (proc_rank == 0)
+            {
+                std::string csv_mode = (mode != "pipeline") ? mode
+                                     : "pipeline_" + segments_arg + (segments > 0 ? "" : "_" + std::to_string(size_segments));
+                bench_csv(bench_config, "collective_operations", csv_mode, proc_num, size, stats);
+            }
+        }
+    }
+    else
+    {
+        const int left_elems = num_len % proc_num; // остаток от деления длины вектора на количество процессов
+        const int new_len = num_len + (left_elems == 0 ? 0 : (proc_num - left_elems)); // увеличение длины вектора, чтобы остаток был равен 0
+        const int chunk_len = new_len / proc_num; // длины отправляемых через scatter сегментов
 
-    MPI_Finalize();
-    return 0;
+        if (proc_rank == 0) 
+        {
+            num.resize(new_len, 0);
+            std::fill(num.begin(), num.begin() + num_len, 1); // заполнение массива единицами (по исходной длине)
+        }
+
+        if (mode == "pipeline" && segments == 0)
+        {
+            segments = tune_segments(num, chunk_len, proc_num);
+        }
+
+        start_time = MPI_Wtime(); 
+        int global_sum = (mode == "pipeline") ? pipelined_scatter_sum(num, chunk_len, segments, proc_num)
+                                              : scatter_sum(num, chunk_len, node_reducer.get());
+        end_time = MPI_Wtime();
+
+        if (proc_rank == 0) 
+        {
+            if (mode == "pipeline")
+            {
+                std::cout << "Segments: " << std::min(segments, chunk_len) << (segments_arg == "auto" ? " (auto)" : "") << std::endl;
+            }
+            std::cout << "Total execution time: " << end_time - start_time << " seconds" << std::endl;
+            std::cout << "Total sum: " << global_sum << std::endl;
+        }
+    }
 }
 
 int read_num_len(int argc, char** argv, int proc_rank)
@@ -66,7 +173,7 @@ int read_num_len(int argc, char** argv, int proc_rank)
 
     if (num_len < 1)
     {
-        if (proc_rank == 0)
+        if (proc_rank == 0) 
         {
             std::cerr << "Error: Array size must be greater than or equal to 1." << std::endl;
         }
@@ -76,3 +183,158 @@ int read_num_len(int argc, char** argv, int proc_rank)
 
     return num_len;
 }
+
+// рассылка сегментов по chunk_len элементов, локальные суммы и их редукция на нулевой процесс
+// (двухуровневая, если node_reducer не нулевой)
+int scatter_sum(const std::vector<int>& num, int chunk_len, NodeReducer* node_reducer)
+{
+    std::vector<int> local_chunk(chunk_len); // массив под сегмент
+
+    // отравление всем процессам в коммутаторе сегментов массива
+    MPI_Scatter(num.data(), chunk_len, MPI_INT, local_chunk.data(), chunk_len, MPI_INT, 0, MPI_COMM_WORLD); 
+
+    int local_sum = std::accumulate(local_chunk.begin(), local_chunk.end(), 0); // высчитывание локальной суммы
+
+    int global_sum = 0;
+    if (node_reducer)
+    {
+        node_reducer->reduce(&local_sum, &global_sum, MPI_SUM); // сумма внутри узла через общую память, затем между лидерами узлов
+    }
+    else
+    {
+        MPI_Reduce(&local_sum, &global_sum, 1, MPI_INT, MPI_SUM, 0, MPI_COMM_WORLD); // высчитывание суммы локальных сумм, отправка ее на нулевой процесс
+    }
+
+    return global_sum;
+}
+
+// Конвейерная рассылка: сегмент каждого процесса делится на segments частей, часть i + 1 рассылается MPI_Iscatterv,
+// пока суммируется часть i (двойной буфер). Сумма каждой части сразу отправляется неблокирующим MPI_Ireduce,
+// так что редукция первых частей идет параллельно с вычислениями над последними; нулевой процесс складывает
+// результаты редукций в конце. Без асинхронного прогресса в реализации MPI пересылки продвигаются только
+// внутри вызовов MPI, поэтому суммирование прерывается вызовом MPI_Test каждые PROGRESS_STRIDE элементов.
+int pipelined_scatter_sum(const std::vector<int>& num, int chunk_len, int segments, int proc_num)
+{
+    segments = std::min(segments, chunk_len);
+
+    // у двух одновременно идущих рассылок свои буферы и массивы counts / displs
+    std::vector<int> buffers[2], counts[2], displs[2];
+    MPI_Request scatter_requests[2];
+    for (int i = 0; i < 2; i++)
+    {
+        buffers[i].resize(chunk_len / segments + 1);
+        counts[i].resize(proc_num);
+        displs[i].resize(proc_num);
+    }
+
+    std::vector<int> partials(segments, 0), totals(segments, 0);
+    std::vector<MPI_Request> reduce_requests(segments);
+
+    auto start_segment = [&](int i)
+    {
+        int offset, count;
+        block_range(chunk_len, segments, i, offset, count);
+        for (int rank = 0; rank < proc_num; rank++)
+        {
+            counts[i % 2][rank] = count;
+            displs[i % 2][rank] = rank * chunk_len + offset;
+        }
+        MPI_Iscatterv(num.data(), counts[i % 2].data(), displs[i % 2].data(), MPI_INT,
+                      buffers[i % 2].data(), count, MPI_INT, 0, MPI_COMM_WORLD, &scatter_requests[i % 2]);
+    };
+
+    start_segment(0);
+    for (int i = 0; i < segments; i++)
+    {
+        MPI_Wait(&scatter_requests[i % 2], MPI_STATUS_IGNORE);
+        if (i + 1 < segments)
+        {
+            start_segment(i + 1);
+        }
+
+        int offset, count;
+        block_range(chunk_len, segments, i, offset, count);
+        const int* data = buffers[i % 2].data();
+        for (int begin = 0; begin < count; begin += PROGRESS_STRIDE)
+        {
+            partials[i] = std::accumulate(data + begin, data + std::min(count, begin + PROGRESS_STRIDE), partials[i]);
+            if (i + 1 < segments)
+            {
+                int flag;
+                MPI_Test(&scatter_requests[(i + 1) % 2], &flag, MPI_STATUS_IGNORE);
+            }
+        }
+
+        MPI_Ireduce(&partials[i], &totals[i], 1, MPI_INT, MPI_SUM, 0, MPI_COMM_WORLD, &reduce_requests[i]);
+    }
+    MPI_Waitall(segments, reduce_requests.data(), MPI_STATUSES_IGNORE);
+
+    return std::accumulate(totals.begin(), totals.end(), 0); // осмысленна только на нулевом процессе
+}
+
+// Подбор количества сегментов по замерам: alpha - задержка рассылки, beta - время рассылки одного элемента,
+// gamma - время суммирования одного элемента (максимумы по процессам). Время конвейера из K частей
+// T(K) ~ max(beta, gamma) * n + min(beta, gamma) * n / K + K * alpha, минимум при K = sqrt(min(beta, gamma) * n / alpha).
+int tune_segments(const std::vector<int>& num, int chunk_len, int proc_num)
+{
+    const int probe_len = std::min(chunk_len, PROBE_LEN);
+    std::vector<int> counts(proc_num), displs(proc_num), buffer(probe_len);
+    for (int rank = 0; rank < proc_num; rank++)
+    {
+        displs[rank] = rank * chunk_len;
+    }
+
+    auto scatter_time = [&](int count)
+    {
+        std::fill(counts.begin(), counts.end(), count);
+        MPI_Barrier(MPI_COMM_WORLD);
+        double start_time = MPI_Wtime();
+        for (int i = 0; i < PROBE_REPS; i++)
+        {
+            MPI_Scatterv(num.data(), counts.data(), displs.data(), MPI_INT, buffer.data(), count, MPI_INT, 0, MPI_COMM_WORLD);
+        }
+        return (MPI_Wtime() - start_time) / PROBE_REPS;
+    };
+
+    double local[3], global[3];
+    local[0] = scatter_time(1);
+    local[1] = std::max(0.0, scatter_time(probe_len) - local[0]) / probe_len;
+
+    volatile int sink = 0; // результат суммирования используется, чтобы цикл не был удален компилятором
+    double start_time = MPI_Wtime();
+    for (int i = 0; i < PROBE_REPS; i++)
+    {
+        sink = sink + std::accumulate(buffer.begin(), buffer.end(), 0);
+    }
+    local[2] = (MPI_Wtime() - start_time) / PROBE_REPS / probe_len;
+
+    // одинаковые значения на всех процессах, поэтому и K у всех одинаковое
+    MPI_Allreduce(local, global, 3, MPI_DOUBLE, MPI_MAX, MPI_COMM_WORLD);
+
+    double k = std::sqrt(std::min(global[1], global[2]) * chunk_len / std::max(global[0], 1e-9));
+    return std::max(1, std::min({static_cast<int>(std::lround(k)), chunk_len, MAX_SEGMENTS}));
+}
+
+// сравнение MPI_Reduce и двухуровневой редукции одного int без рассылки данных
+void bench_reduce(NodeReducer& node_reducer, const BenchConfig& bench_config, int proc_rank, int proc_num)
+{
+    int local_sum = proc_rank;
+    int global_sum = 0;
+
+    BenchStats flat_stats = bench_run(MPI_COMM_WORLD, bench_config, [&]
+    {
+        MPI_Reduce(&local_sum, &global_sum, 1, MPI_INT, MPI_SUM, 0, MPI_COMM_WORLD);
+    });
+    BenchStats node_stats = bench_run(MPI_COMM_WORLD, bench_config, [&]
+    {
+        node_reducer.reduce(&local_sum, &global_sum, MPI_SUM);
+    });
+
+    if (proc_rank == 0) 
+    {
+        std::cout << "Processes: " << proc_num << ", nodes: " << node_reducer.nodes()
+                  << ", processes on node 0: " << node_reducer.node_size() << std::endl;
+        bench_csv(bench_config, "collective_operations", "reduce_flat", proc_num, proc_num, flat_stats);
+        bench_csv(bench_config, "collective_operations", "reduce_node", proc_num, proc_num, node_stats);
+    }
+}
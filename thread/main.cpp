@@ -7,12 +7,18 @@
 #include <random>
 #include <map>
 #include <vector>
-#include <atomic>
 #include <utility>
 #include <fstream>
 #include <iomanip>
 #include <sstream>
 #include <filesystem> 
+#include <string>
+#include <algorithm>
+#include <atomic>
+#include <memory>
+#include <pthread.h>
+#include <sched.h>
+#include "workload.h"
 
 // Тип события: вход или выход
 enum class EventType 
@@ -41,12 +47,96 @@ private:
 public:
     void push(const T&); // Добавление элемента в очередь
     void pop(T&); // Извлечение элемента из очереди. Если очередь пуста, ожидается появление элемента
+    void pop_batch(std::vector<T>&, std::size_t); // Извлечение до max элементов за одну блокировку; ожидается хотя бы один
     bool empty();
 };
 
+// Ограниченная очередь для одного производителя и одного потребителя (кольцевой буфер без блокировок).
+// Соединяет соседние стадии конвейера обработки: каждую позицию меняет только один поток,
+// поэтому достаточно двух атомарных счетчиков. При заполнении производитель ждет потребителя (обратное давление).
+// Ожидание: сначала SPSC_SPIN_TRIES проверок с yield, затем поток засыпает на условной переменной,
+// чтобы простаивающие стадии не занимали ядра между окнами событий
+const int SPSC_SPIN_TRIES = 100;
+
+template <typename T>
+class SpscQueue
+{
+private:
+    std::vector<T> buffer;
+    std::size_t capacity;
+    alignas(64) std::atomic<std::size_t> head{0}; // следующая позиция чтения (меняет только потребитель)
+    alignas(64) std::atomic<std::size_t> tail{0}; // следующая позиция записи (меняет только производитель)
+    alignas(64) std::atomic<int> sleeping{0};     // число потоков, заснувших в wait_for
+    std::mutex mtx;
+    std::condition_variable cv;
+
+    template <typename Ready> void wait_for(Ready); // ожидание выполнения условия: ограниченный спин, затем сон
+    void wake();                                    // пробуждение заснувшего потока после изменения head / tail
+public:
+    explicit SpscQueue(std::size_t);
+    void push(T&&); // Добавление элемента; если очередь заполнена, ожидается свободное место
+    void pop(T&);   // Извлечение элемента; если очередь пуста, ожидается появление элемента
+};
+
+// событие на пути через конвейер обработки; поля заполняются стадиями
+struct Record
+{
+    Event ev;
+    std::string time_string; // decode: время события в формате ЧЧ:ММ:СС
+    int entry_station = 0;   // match: станция входа для EXIT, 0 - вход не найден
+};
+
+using Batch = std::vector<Record>; // пакет событий, передаваемый между стадиями; пустой пакет - конец потока
+
+// шаги обработки события в порядке конвейера; шаги распределяются по стадиям (потокам) подряд
+const int NUM_STEPS = 4;
+const char* const STEP_NAMES[NUM_STEPS] = {"decode", "match", "aggregate", "log"};
+
+// счетчики стадии; меняются только потоком стадии, читаются после его завершения
+struct StageStats
+{
+    long long events = 0;
+    long long batches = 0;
+    double busy_time = 0; // время обработки пакетов без ожидания очередей, секунды
+};
+
+// Барьер потоков-симуляторов: события следующей минуты моделируемого времени попадают в очередь
+// только после того, как все станции выдали события текущей минуты
+class WindowBarrier
+{
+private:
+    std::mutex mtx;
+    std::condition_variable cv;
+    int num_threads;
+    int waiting = 0;
+    long long generation = 0;
+public:
+    explicit WindowBarrier(int);
+    void arrive_and_wait(); // ожидание, пока все num_threads потоков не дойдут до барьера
+};
+
+// параметры запуска
+struct SimulationParams
+{
+    int num_stations;
+    int sleep_time;    // за сколько секунд воспроизводятся сутки
+    bool fast = false; // воспроизведение без пауз
+    WorkloadConfig workload;
+    int stages = NUM_STEPS;  // количество стадий (потоков) конвейера обработки, 1..NUM_STEPS
+    int queue_capacity = 64; // емкость очередей между стадиями, пакетов
+    int batch_size = 64;     // событий в пакете
+    bool pin = true;         // привязка каждой стадии к своему ядру (--no-pin отключает)
+};
+
+const int WINDOW_SECONDS = 60; // шаг воспроизведения, не больше промежутков между событиями одной карты (min_trip, min_dwell)
+
 ThreadSafeQueue<Event> event_queue; // очередь событий
 Event termination_event {-1, 0, EventType::ENTRY, std::chrono::system_clock::now()}; // событие для завершения работы (терминатор); Если card_ID == -1, то событие используется как сигнал завершения работы обработчика
-std::atomic<bool> simulation_running{true}; // флаг для остановки симуляции
+
+std::vector<std::vector<Event>> station_events; // события каждой станции в порядке времени (индекс - номер станции)
+long long num_windows;                          // количество шагов воспроизведения
+std::chrono::microseconds window_duration;      // реальное время одного шага, 0 - без пауз
+std::chrono::steady_clock::time_point simulation_start;
 
 std::map<int, Event> pending_journeys; // для хранения незавершённых маршрутов (только входы)
 std::mutex pending_journeys_mutex;
@@ -57,40 +147,83 @@ std::mutex flow_matrix_mutex;
 std::vector<std::string> event_log;
 std::mutex log_mutex;
 
-std::pair<int, int> read_params(int, char**);
-std::chrono::milliseconds random_interval();
-void update_flow_matrix(int, int);
-void turnstile_simulator(int);
-void event_processor();
+std::vector<StageStats> stage_stats; // счетчики каждой стадии конвейера
+
+SimulationParams read_params(int, char**);
+std::chrono::system_clock::time_point day_start();
+long long build_station_events(const std::vector<Journey>&, int);
+void turnstile_simulator(int, WindowBarrier&);
+void pipeline_stage(int, int, int, SpscQueue<Batch>*, SpscQueue<Batch>*);
+bool read_event_batch(Batch&, int);
+void run_step(int, Batch&);
+void decode_batch(Batch&);
+void match_batch(Batch&);
+void aggregate_batch(Batch&);
+void log_batch(Batch&);
+std::vector<int> allowed_cpus();
+void pin_thread(std::thread&, int, int);
+void stage_report(const SimulationParams&, double);
 void report_generator();
 void save_log(std::string);
 
 int main(int argc, char* argv[]) 
 {
-    auto [num_stations, sleep_time] = read_params(argc, argv);
+    SimulationParams params = read_params(argc, argv);
+    int num_stations = params.num_stations;
+
+    // поездки генерируются заранее, потоки-симуляторы воспроизводят события своих станций
+    std::vector<Journey> journeys = generate_journeys(params.workload);
+    long long last_time = build_station_events(journeys, num_stations);
+    num_windows = last_time / WINDOW_SECONDS + 1;
+    window_duration = params.fast ? std::chrono::microseconds(0)
+                                  : std::chrono::microseconds(params.sleep_time * 1000000LL / num_windows);
+    std::cout << "Generated " << journeys.size() << " journeys of " << params.workload.num_cards
+              << " cards at " << num_stations << " stations (seed " << params.workload.seed << ")" << std::endl;
     
     // потоки-симуляторы для каждой станции
+    WindowBarrier window_barrier(num_stations);
+    simulation_start = std::chrono::steady_clock::now();
     std::vector<std::thread> producer_threads;
     for (int i = 1; i <= num_stations; i++) 
-        producer_threads.emplace_back(turnstile_simulator, i);
-    
-    // поток-обработчик событий
-    std::thread consumer_thread(event_processor);
+        producer_threads.emplace_back(turnstile_simulator, i, std::ref(window_barrier));
     
-    // cимуляция работает заданное время
-    std::this_thread::sleep_for(std::chrono::seconds(sleep_time));
-    simulation_running.store(false);
+    // конвейер обработки: stages потоков, соседние стадии связаны очередями SPSC.
+    // Каждая стадия обрабатывает пакеты по порядку, поэтому порядок событий (и событий каждой карты) сохраняется
+    std::vector<std::unique_ptr<SpscQueue<Batch>>> stage_queues; // stage_queues[s] - между стадиями s и s + 1
+    for (int s = 0; s + 1 < params.stages; s++)
+        stage_queues.emplace_back(new SpscQueue<Batch>(params.queue_capacity));
+
+    stage_stats.assign(params.stages, StageStats());
+    auto processing_start = std::chrono::steady_clock::now();
+    // каждая стадия на своем ядре из разрешенных процессу (sched_getaffinity: taskset, cpuset);
+    // если ядер меньше, чем стадий, стадии не привязываются - иначе несколько стадий делили бы одно ядро, пока другие простаивают
+    std::vector<int> cpus = allowed_cpus();
+    if (params.pin && static_cast<int>(cpus.size()) < params.stages)
+        params.pin = false;
+    std::vector<std::thread> stage_threads;
+    for (int s = 0; s < params.stages; s++)
+    {
+        SpscQueue<Batch>* input = (s > 0) ? stage_queues[s - 1].get() : nullptr;
+        SpscQueue<Batch>* output = (s + 1 < params.stages) ? stage_queues[s].get() : nullptr;
+        stage_threads.emplace_back(pipeline_stage, s, params.stages, params.batch_size, input, output);
+        if (params.pin)
+            pin_thread(stage_threads.back(), s, cpus[s]);
+    }
     
-    // ожидание завершения потоков-симуляторов
+    // ожидание завершения потоков-симуляторов (все события воспроизведены)
     for (auto& t : producer_threads)
         if (t.joinable())
             t.join();
     
-    // для завершения потока-обработчика отправляется терминальное событие
+    // для завершения конвейера отправляется терминальное событие, стадии передают конец потока дальше
     event_queue.push(termination_event);
-    if (consumer_thread.joinable())
-        consumer_thread.join();
+    for (auto& t : stage_threads)
+        if (t.joinable())
+            t.join();
+    double processing_time = std::chrono::duration<double>(std::chrono::steady_clock::now() - processing_start).count();
     
+    stage_report(params, processing_time);
+
     // вывод сводной таблицы пассажиропотока
     report_generator();
     save_log("event_log.txt");
@@ -149,134 +282,403 @@ template <typename T> bool ThreadSafeQueue<T>::empty() // проверка, чт
     return queue.empty();
 }
 
-// чтение количества станций и времени симуляции из командой строки
-// по умолчанию 5 и 10
-std::pair<int, int> read_params(int argc, char** argv)
+template <typename T> void ThreadSafeQueue<T>::pop_batch(std::vector<T>& items, std::size_t max) // извлечение пакета элементов
 {
-    int num_stations;
-    int sleep_time;
+    std::unique_lock<std::mutex> lock(mtx);
+    cv.wait(lock, [this]{return !queue.empty();});
+    while (!queue.empty() && items.size() < max)
+    {
+        items.push_back(queue.front());
+        queue.pop();
+    }
+}
+
+template <typename T> SpscQueue<T>::SpscQueue(std::size_t capacity) : buffer(capacity), capacity(capacity) {}
+
+// head, tail и sleeping используют последовательную согласованность: поток, который засыпает (sleeping, затем head / tail),
+// и поток, который будит (head / tail, затем sleeping), не могут оба прочитать старые значения - пробуждение не теряется
+template <typename T> template <typename Ready> void SpscQueue<T>::wait_for(Ready ready)
+{
+    for (int i = 0; i < SPSC_SPIN_TRIES; i++)
+    {
+        if (ready())
+            return;
+        std::this_thread::yield();
+    }
+    std::unique_lock<std::mutex> lock(mtx);
+    sleeping++;
+    cv.wait(lock, ready);
+    sleeping--;
+}
+
+template <typename T> void SpscQueue<T>::wake()
+{
+    if (sleeping.load() > 0)
+    {
+        std::lock_guard<std::mutex> lock(mtx);
+        cv.notify_one();
+    }
+}
 
-    if (argc < 2)
+template <typename T> void SpscQueue<T>::push(T&& item) // добавление элемента в очередь
+{
+    std::size_t t = tail.load(std::memory_order_relaxed);
+    wait_for([this, t]{return t - head.load() != capacity;});
+    buffer[t % capacity] = std::move(item);
+    tail.store(t + 1);
+    wake();
+}
+
+template <typename T> void SpscQueue<T>::pop(T& item) // извлечение элемента из очереди
+{
+    std::size_t h = head.load(std::memory_order_relaxed);
+    wait_for([this, h]{return tail.load() != h;});
+    item = std::move(buffer[h % capacity]);
+    head.store(h + 1);
+    wake();
+}
+
+WindowBarrier::WindowBarrier(int num_threads) : num_threads(num_threads) {}
+
+void WindowBarrier::arrive_and_wait()
+{
+    std::unique_lock<std::mutex> lock(mtx);
+    long long current = generation;
+    if (++waiting == num_threads)
     {
-        num_stations = 5;
-        sleep_time = 10;
+        waiting = 0;
+        generation++;
+        cv.notify_all();
     }
     else
     {
-        num_stations = std::atoi(argv[1]);
-        sleep_time = std::atoi(argv[2]);
+        cv.wait(lock, [this, current]{return generation != current;});
     }
+}
 
-    if (num_stations < 1 || sleep_time < 1)
+// чтение количества станций, времени симуляции и параметров нагрузки из командой строки
+// по умолчанию 5 станций и 10 секунд; --seed=N --cards=N --journeys=N --card-skew=X --station-skew=X --fast
+// конвейер обработки: --stages=N --queue=N --batch=N --no-pin
+SimulationParams read_params(int argc, char** argv)
+{
+    SimulationParams params;
+    std::vector<std::string> positional;
+
+    for (int i = 1; i < argc; i++)
+    {
+        std::string arg = argv[i];
+        if (arg.compare(0, 2, "--") != 0)
+        {
+            positional.push_back(arg);
+            continue;
+        }
+
+        std::string key = arg.substr(2, arg.find('=') - 2);
+        std::string value = (arg.find('=') == std::string::npos) ? "" : arg.substr(arg.find('=') + 1);
+
+        if (key == "seed")
+            params.workload.seed = std::strtoull(value.c_str(), nullptr, 10);
+        else if (key == "cards")
+            params.workload.num_cards = std::atoi(value.c_str());
+        else if (key == "journeys")
+            params.workload.journeys = std::atoll(value.c_str());
+        else if (key == "card-skew")
+            params.workload.card_skew = std::atof(value.c_str());
+        else if (key == "station-skew")
+            params.workload.station_skew = std::atof(value.c_str());
+        else if (key == "fast")
+            params.fast = true;
+        else if (key == "stages")
+            params.stages = std::atoi(value.c_str());
+        else if (key == "queue")
+            params.queue_capacity = std::atoi(value.c_str());
+        else if (key == "batch")
+            params.batch_size = std::atoi(value.c_str());
+        else if (key == "pin")
+            params.pin = true;
+        else if (key == "no-pin")
+            params.pin = false;
+        else
+        {
+            std::cerr << "Error: unknown option " << arg << "." << std::endl;
+            exit(1);
+        }
+    }
+
+    params.num_stations = (positional.size() > 0) ? std::atoi(positional[0].c_str()) : 5;
+    params.sleep_time = (positional.size() > 1) ? std::atoi(positional[1].c_str()) : 10;
+    params.workload.num_stations = params.num_stations;
+
+    if (params.num_stations < 1 || params.sleep_time < 1)
     {
         std::cerr << "Error: num_stations and sleep_time must be greater than or equal to 1." << std::endl;
         exit(1);
     }
+    if (params.workload.num_cards < 1 || params.workload.journeys < 0
+        || params.workload.card_skew < 0 || params.workload.station_skew < 0)
+    {
+        std::cerr << "Error: cards must be >= 1, journeys and skews must be >= 0." << std::endl;
+        exit(1);
+    }
+    if (params.stages < 1 || params.stages > NUM_STEPS || params.queue_capacity < 1 || params.batch_size < 1)
+    {
+        std::cerr << "Error: stages must be between 1 and " << NUM_STEPS << ", queue and batch must be >= 1." << std::endl;
+        exit(1);
+    }
+
+    return params;
+}
+
+// начало моделируемых суток (фиксированная дата, чтобы лог не зависел от дня запуска)
+std::chrono::system_clock::time_point day_start()
+{
+    std::tm day = {};
+    day.tm_year = 2024 - 1900;
+    day.tm_mon = 0;
+    day.tm_mday = 15;
+    day.tm_isdst = -1;
+    return std::chrono::system_clock::from_time_t(std::mktime(&day));
+}
+
+// раскладка поездок на события станций (вход - на станции входа, выход - на станции выхода);
+// возвращает время последнего события в секундах от начала суток
+long long build_station_events(const std::vector<Journey>& journeys, int num_stations)
+{
+    const auto start = day_start();
+    long long last_time = 0;
+
+    station_events.assign(num_stations + 1, {});
+    for (const Journey& journey : journeys)
+    {
+        station_events[journey.entry_station].push_back({journey.card_ID, journey.entry_station, EventType::ENTRY,
+                                                         start + std::chrono::seconds(journey.entry_time)});
+        station_events[journey.exit_station].push_back({journey.card_ID, journey.exit_station, EventType::EXIT,
+                                                        start + std::chrono::seconds(journey.exit_time)});
+        last_time = std::max(last_time, journey.exit_time);
+    }
+    for (auto& events : station_events)
+        std::stable_sort(events.begin(), events.end(), [](const Event& a, const Event& b){return a.timestamp < b.timestamp;});
 
-    return {num_stations, sleep_time};
+    return last_time;
 }
 
 // генерации событий турникетов
-// симулирует работу турникета на конкретной станции.
-void turnstile_simulator(int stationID) 
+// воспроизводит события конкретной станции шагами по WINDOW_SECONDS моделируемого времени.
+// Все станции проходят шаги синхронно, поэтому события одной карты на разных станциях
+// попадают в очередь в порядке времени (шаг меньше промежутка между событиями карты)
+void turnstile_simulator(int stationID, WindowBarrier& window_barrier) 
 {
-    static thread_local std::mt19937 generator(std::random_device{}()); // локальный генератор
-    std::uniform_int_distribution<int> cardDistribution(1, 50);    // 50 возможных транспортных карт
-    std::uniform_int_distribution<int> eventTypeDistribution(0, 1);  // 0 - ENTRY, 1 - EXIT
-    
-    while (simulation_running.load()) 
+    const auto start = day_start();
+    const std::vector<Event>& events = station_events[stationID];
+    std::size_t next = 0;
+
+    for (long long window = 0; window < num_windows; window++) 
     {
-        std::this_thread::sleep_for(random_interval()); // симуляция, чтобы пассажир проходил турникет в случайный момент времени
-        
-        Event ev;
-        ev.card_ID = cardDistribution(generator);
-        ev.station_ID = stationID;
-        ev.timestamp = std::chrono::system_clock::now();
-        int type = eventTypeDistribution(generator);
-        ev.type = (type == 0) ? EventType::ENTRY : EventType::EXIT;
-        
-        event_queue.push(ev);
+        if (window_duration.count() > 0)
+            std::this_thread::sleep_until(simulation_start + window * window_duration); // темп: сутки за sleep_time секунд
+
+        auto window_end = start + std::chrono::seconds((window + 1) * WINDOW_SECONDS);
+        for (; next < events.size() && events[next].timestamp < window_end; next++)
+            event_queue.push(events[next]);
+
+        window_barrier.arrive_and_wait();
+    }
+}
+
+// стадия конвейера обработки: выполняет над каждым пакетом шаги [first_step, last_step).
+// Первая стадия читает события из общей очереди, остальные - пакеты из очереди предыдущей стадии
+void pipeline_stage(int stage, int num_stages, int batch_size, SpscQueue<Batch>* input, SpscQueue<Batch>* output)
+{
+    const int first_step = stage * NUM_STEPS / num_stages;
+    const int last_step = (stage + 1) * NUM_STEPS / num_stages;
+    StageStats& stats = stage_stats[stage];
+
+    bool done = false;
+    while (!done)
+    {
+        Batch batch;
+        if (input)
+        {
+            input->pop(batch);
+            done = batch.empty();
+        }
+        else
+        {
+            done = read_event_batch(batch, batch_size);
+        }
+
+        if (!batch.empty())
+        {
+            auto start = std::chrono::steady_clock::now();
+            for (int step = first_step; step < last_step; step++)
+                run_step(step, batch);
+            stats.busy_time += std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+            stats.events += batch.size();
+            stats.batches++;
+
+            if (output)
+                output->push(std::move(batch));
+        }
     }
+
+    // пустой пакет - конец потока для следующей стадии
+    if (output)
+        output->push(Batch());
 }
 
-// обработки событий
-// cобытия извлекаются из очереди. При событии ENTRY данные сохраняются, при EXIT ищется соответствие и обновляется сводная таблица
-void event_processor() 
+// пакет до batch_size событий из общей очереди; true, если получено терминальное событие
+bool read_event_batch(Batch& batch, int batch_size)
 {
-    while (true) 
+    std::vector<Event> events;
+    event_queue.pop_batch(events, batch_size);
+    for (const Event& ev : events)
     {
-        Event ev;
-        event_queue.pop(ev);
-        
-        // Если получено терминальное событие, обработка завершается
+        // Если получено терминальное событие, обработка завершается (оно отправляется последним)
         if (ev.card_ID == -1)
-            break;
-        
-        std::string log_entry;
+            return true;
+        batch.push_back(Record{ev, {}, 0});
+    }
+    return false;
+}
+
+void run_step(int step, Batch& batch)
+{
+    switch (step)
+    {
+        case 0: decode_batch(batch); break;
+        case 1: match_batch(batch); break;
+        case 2: aggregate_batch(batch); break;
+        default: log_batch(batch); break;
+    }
+}
 
-        std::time_t event_time = std::chrono::system_clock::to_time_t(ev.timestamp);
-        std::tm* tm_event = std::localtime(&event_time);
+// форматирование времени событий
+void decode_batch(Batch& batch)
+{
+    for (Record& record : batch)
+    {
+        std::time_t event_time = std::chrono::system_clock::to_time_t(record.ev.timestamp);
+        std::tm* tm_event = std::localtime(&event_time); // вызывается только потоком этой стадии
         std::ostringstream time_stream;
         time_stream << std::put_time(tm_event, "%H:%M:%S"); // Формат: часы:минуты:секунды
-        std::string time_string = time_stream.str();
+        record.time_string = time_stream.str();
+    }
+}
 
-        if (ev.type == EventType::ENTRY) 
+// При событии ENTRY данные сохраняются, при EXIT ищется соответствие
+void match_batch(Batch& batch)
+{
+    std::lock_guard<std::mutex> lock(pending_journeys_mutex); // одна блокировка на пакет
+    for (Record& record : batch)
+    {
+        if (record.ev.type == EventType::ENTRY)
         {
-            {
-                std::lock_guard<std::mutex> lock(pending_journeys_mutex);
-                pending_journeys[ev.card_ID] = ev;
-            }
-            log_entry = "Passenger " + std::to_string(ev.card_ID) +
-                       " entered station " + std::to_string(ev.station_ID) + 
-                       " at time " + time_string;
+            pending_journeys[record.ev.card_ID] = record.ev;
         }
-        else if (ev.type == EventType::EXIT) 
+        else
         {
-            bool matched = false;
-            {
-                std::lock_guard<std::mutex> lock(pending_journeys_mutex);
-                auto it = pending_journeys.find(ev.card_ID);
-                if (it != pending_journeys.end()) 
-                {
-                    // обновление сводной таблицы: пара (входная станция, текущая станция выхода)
-                    update_flow_matrix(it->second.station_ID, ev.station_ID);
-                    log_entry = "Passenger " + std::to_string(ev.card_ID) +
-                               " traveled from station " + std::to_string(it->second.station_ID) + 
-                               " to station " + std::to_string(ev.station_ID) + 
-                               " at time " + time_string;
-                    pending_journeys.erase(it);
-                    matched = true;
-                }
-            }
-            if (!matched)
+            auto it = pending_journeys.find(record.ev.card_ID);
+            if (it != pending_journeys.end())
             {
-                log_entry = "Passenger " + std::to_string(ev.card_ID) +
-                           " exited station " + std::to_string(ev.station_ID) +
-                           " without a recorded entry at time " + time_string;
+                record.entry_station = it->second.station_ID;
+                pending_journeys.erase(it);
             }
         }
-        // добавление запись в лог
+    }
+}
+
+// обновление сводной таблицы: пара (входная станция, станция выхода)
+void aggregate_batch(Batch& batch)
+{
+    std::lock_guard<std::mutex> lock(flow_matrix_mutex);
+    for (const Record& record : batch)
+    {
+        if (record.ev.type == EventType::EXIT && record.entry_station != 0)
+            flow_matrix[std::make_pair(record.entry_station, record.ev.station_ID)]++;
+    }
+}
+
+// добавление записей в лог
+void log_batch(Batch& batch)
+{
+    std::vector<std::string> entries;
+    entries.reserve(batch.size());
+    for (const Record& record : batch)
+    {
+        const Event& ev = record.ev;
+        if (ev.type == EventType::ENTRY) 
+        {
+            entries.push_back("Passenger " + std::to_string(ev.card_ID) +
+                              " entered station " + std::to_string(ev.station_ID) + 
+                              " at time " + record.time_string);
+        }
+        else if (record.entry_station != 0)
+        {
+            entries.push_back("Passenger " + std::to_string(ev.card_ID) +
+                              " traveled from station " + std::to_string(record.entry_station) + 
+                              " to station " + std::to_string(ev.station_ID) + 
+                              " at time " + record.time_string);
+        }
+        else
         {
-            std::lock_guard<std::mutex> lock(log_mutex);
-            event_log.push_back(log_entry);
+            entries.push_back("Passenger " + std::to_string(ev.card_ID) +
+                              " exited station " + std::to_string(ev.station_ID) +
+                              " without a recorded entry at time " + record.time_string);
         }
     }
+
+    std::lock_guard<std::mutex> lock(log_mutex);
+    event_log.insert(event_log.end(), std::make_move_iterator(entries.begin()), std::make_move_iterator(entries.end()));
 }
 
-// оновление сводной таблицы с потокобезопасной синхронизацией
-void update_flow_matrix(int entryStation, int exitStation) 
+// номера ядер, на которых процессу разрешено выполняться
+std::vector<int> allowed_cpus()
 {
-    std::lock_guard<std::mutex> lock(flow_matrix_mutex);
-    std::pair<int, int> key = std::make_pair(entryStation, exitStation);
-    flow_matrix[key]++;
+    std::vector<int> cpus;
+    cpu_set_t cpu_set;
+    CPU_ZERO(&cpu_set);
+    if (sched_getaffinity(0, sizeof(cpu_set), &cpu_set) != 0)
+        return cpus;
+    for (int cpu = 0; cpu < CPU_SETSIZE; cpu++)
+        if (CPU_ISSET(cpu, &cpu_set))
+            cpus.push_back(cpu);
+    return cpus;
+}
+
+// привязка потока стадии stage к ядру cpu (одному из allowed_cpus); при ошибке - только предупреждение
+void pin_thread(std::thread& t, int stage, int cpu)
+{
+    cpu_set_t cpu_set;
+    CPU_ZERO(&cpu_set);
+    CPU_SET(cpu, &cpu_set);
+    if (pthread_setaffinity_np(t.native_handle(), sizeof(cpu_set), &cpu_set) != 0)
+        std::cerr << "Warning: failed to pin stage " << stage << " to core " << cpu << std::endl;
 }
 
-// генерация случайного интервала ожидания 
-std::chrono::milliseconds random_interval() 
+// счетчики стадий: узкое место - стадия с наибольшим временем обработки
+void stage_report(const SimulationParams& params, double processing_time)
 {
-    static thread_local std::mt19937 generator(std::random_device{}());
-    std::uniform_int_distribution<int> distribution(100, 500); // интервал от 100 до 500 мс
-    return std::chrono::milliseconds(distribution(generator));
+    std::cout << "\nPipeline: " << params.stages << " stages, batch " << params.batch_size
+              << " events, queue capacity " << params.queue_capacity << " batches, "
+              << (params.pin ? "pinned" : "not pinned") << ", " << processing_time << " s\n";
+    std::cout << std::left << std::setw(7) << "stage" << std::setw(28) << "steps" << std::setw(12) << "events"
+              << std::setw(10) << "batches" << std::setw(12) << "busy, s" << "events/s busy\n";
+
+    int bottleneck = 0;
+    for (int s = 0; s < params.stages; s++)
+    {
+        std::string steps;
+        for (int step = s * NUM_STEPS / params.stages; step < (s + 1) * NUM_STEPS / params.stages; step++)
+            steps += (steps.empty() ? "" : "+") + std::string(STEP_NAMES[step]);
+
+        const StageStats& stats = stage_stats[s];
+        double rate = (stats.busy_time > 0) ? stats.events / stats.busy_time : 0;
+        std::cout << std::left << std::setw(7) << s << std::setw(28) << steps << std::setw(12) << stats.events
+                  << std::setw(10) << stats.batches << std::setw(12) << stats.busy_time << rate << "\n";
+        if (stats.busy_time > stage_stats[bottleneck].busy_time)
+            bottleneck = s;
+    }
+    std::cout << "Bottleneck: stage " << bottleneck << std::endl;
 }
 
 // по завершении симуляции выводится сводная таблица пассажиропотока.
@@ -0,0 +1,168 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <random>
+#include <vector>
+
+// Детерминированный генератор нагрузки для симулятора турникетов.
+// Один и тот же seed дает одну и ту же последовательность поездок на любой платформе:
+// используется только выход std::mt19937_64 (он определен стандартом), а не std::*_distribution,
+// результаты которых зависят от реализации стандартной библиотеки.
+//
+// Модель суток:
+//   - время начала поездок распределено по кривой интенсивности с утренним и вечерним часом пик,
+//     ночью (с 1:00 до 5:30) метро закрыто;
+//   - карта поездки выбирается по закону Зипфа: немногие карты ездят часто, большинство - редко;
+//   - станции входа и выхода также выбираются по Зипфу (популярность станций), выход отличается от входа;
+//   - поездки одной карты не пересекаются: следующий вход не раньше min_dwell после предыдущего выхода,
+//     поэтому каждому выходу предшествует вход той же карты. Если выбранная карта еще в пути, карта
+//     выбирается заново (до MAX_CARD_REDRAWS раз), и только затем поездка откладывается до ее освобождения -
+//     иначе самые частые карты Зипфа растянули бы свои поездки далеко за пределы суток.
+
+struct WorkloadConfig
+{
+    std::uint64_t seed = 42;
+    int num_stations = 5;
+    int num_cards = 50;
+    long long journeys = 500;
+    double card_skew = 1.0;    // показатель Зипфа для карт (0 - равномерно)
+    double station_skew = 0.8; // показатель Зипфа для станций
+    int min_trip = 240;        // длительность поездки, секунды
+    int max_trip = 2700;
+    int min_dwell = 60;        // минимальный промежуток между выходом и следующим входом той же карты, секунды
+};
+
+const int MAX_CARD_REDRAWS = 16;
+
+// поездка: время в секундах от начала суток
+struct Journey
+{
+    int card_ID;
+    int entry_station;
+    int exit_station;
+    long long entry_time;
+    long long exit_time;
+};
+
+// равномерное число из [0, 1) по 53 старшим битам
+inline double uniform01(std::mt19937_64& generator)
+{
+    return (generator() >> 11) * (1.0 / 9007199254740992.0);
+}
+
+// Распределение Зипфа на 1..n с показателем s (P(k) ~ 1 / k^s), метод rejection-inversion (Hörmann, Derflinger).
+// Память O(1), поэтому подходит для миллионов карт.
+class ZipfDistribution
+{
+private:
+    int n;
+    double exponent;
+    double h_integral_x1, h_integral_n, threshold;
+
+    static double helper1(double x) // log(1 + x) / x
+    {
+        return (std::abs(x) > 1e-8) ? std::log1p(x) / x : 1 - x * (0.5 - x * (1.0 / 3 - 0.25 * x));
+    }
+    static double helper2(double x) // (exp(x) - 1) / x
+    {
+        return (std::abs(x) > 1e-8) ? std::expm1(x) / x : 1 + x * 0.5 * (1 + x / 3 * (1 + 0.25 * x));
+    }
+    double h(double x) const { return std::exp(-exponent * std::log(x)); }
+    double h_integral(double x) const
+    {
+        double log_x = std::log(x);
+        return helper2((1 - exponent) * log_x) * log_x;
+    }
+    double h_integral_inverse(double x) const
+    {
+        double t = std::max(-1.0, x * (1 - exponent));
+        return std::exp(helper1(t) * x);
+    }
+
+public:
+    ZipfDistribution(int n, double exponent) : n(n), exponent(exponent)
+    {
+        h_integral_x1 = h_integral(1.5) - 1;
+        h_integral_n = h_integral(n + 0.5);
+        threshold = 2 - h_integral_inverse(h_integral(2.5) - h(2));
+    }
+
+    int operator()(std::mt19937_64& generator) const
+    {
+        while (true)
+        {
+            double u = h_integral_n + uniform01(generator) * (h_integral_x1 - h_integral_n);
+            double x = h_integral_inverse(u);
+            int k = std::min(n, std::max(1, static_cast<int>(x + 0.5)));
+            if (k - x <= threshold || u >= h_integral(k + 0.5) - h(k))
+            {
+                return k;
+            }
+        }
+    }
+};
+
+// относительная интенсивность входов в момент hour (часы от начала суток)
+inline double rush_hour_rate(double hour)
+{
+    if (hour >= 1.0 && hour < 5.5)
+    {
+        return 0; // метро закрыто
+    }
+    double morning = (hour - 8.5) / 0.9;
+    double evening = (hour - 18.0) / 1.2;
+    return 1.0 + 6.0 * std::exp(-morning * morning / 2) + 5.0 * std::exp(-evening * evening / 2);
+}
+
+// поездки суток в порядке начала (с учетом сдвига из-за предыдущих поездок той же карты)
+inline std::vector<Journey> generate_journeys(const WorkloadConfig& config)
+{
+    std::mt19937_64 generator(config.seed);
+    ZipfDistribution card_distribution(config.num_cards, config.card_skew);
+    ZipfDistribution station_distribution(config.num_stations, config.station_skew);
+
+    // функция распределения времени начала поездки по минутам суток
+    const int minutes = 24 * 60;
+    std::vector<double> cdf(minutes);
+    double total = 0;
+    for (int i = 0; i < minutes; i++)
+    {
+        total += rush_hour_rate((i + 0.5) / 60);
+        cdf[i] = total;
+    }
+
+    std::vector<long long> start_times(config.journeys);
+    for (long long& start : start_times)
+    {
+        int minute = std::upper_bound(cdf.begin(), cdf.end(), uniform01(generator) * total) - cdf.begin();
+        start = 60LL * std::min(minute, minutes - 1) + static_cast<long long>(uniform01(generator) * 60);
+    }
+    std::sort(start_times.begin(), start_times.end());
+
+    std::vector<long long> card_free_at(config.num_cards + 1, 0); // когда карта может снова войти
+    std::vector<Journey> journeys;
+    journeys.reserve(config.journeys);
+    for (long long start : start_times)
+    {
+        Journey journey;
+        journey.card_ID = card_distribution(generator);
+        for (int i = 0; i < MAX_CARD_REDRAWS && card_free_at[journey.card_ID] > start; i++)
+        {
+            journey.card_ID = card_distribution(generator);
+        }
+        journey.entry_station = station_distribution(generator);
+        journey.exit_station = journey.entry_station;
+        while (config.num_stations > 1 && journey.exit_station == journey.entry_station)
+        {
+            journey.exit_station = station_distribution(generator);
+        }
+        journey.entry_time = std::max(start, card_free_at[journey.card_ID]);
+        journey.exit_time = journey.entry_time + config.min_trip
+                          + static_cast<long long>(uniform01(generator) * (config.max_trip - config.min_trip + 1));
+        card_free_at[journey.card_ID] = journey.exit_time + config.min_dwell;
+        journeys.push_back(journey);
+    }
+    return journeys;
+}